@@ -67,6 +67,9 @@ bufgrow(struct buf *buf, size_t neosz)
 	while (neoasz < neosz)
 		neoasz += buf->unit;
 
+	if (buf->grow)
+		return buf->grow(buf, neoasz);
+
 	neodata = realloc(buf->data, neoasz);
 	if (!neodata)
 		return BUF_ENOMEM;
@@ -88,10 +91,25 @@ bufnew(size_t unit)
 		ret->data = 0;
 		ret->size = ret->asize = 0;
 		ret->unit = unit;
+		ret->grow = NULL;
+		ret->store = NULL;
 	}
 	return ret;
 }
 
+/* bufinit_store: initialization of a buffer over an external store */
+void
+bufinit_store(struct buf *buf, size_t unit, int (*grow)(struct buf *, size_t), void *store)
+{
+	assert(buf && unit && grow);
+
+	buf->data = 0;
+	buf->size = buf->asize = 0;
+	buf->unit = unit;
+	buf->grow = grow;
+	buf->store = store;
+}
+
 /* bufnullterm: NULL-termination of the string array */
 const char *
 bufcstr(const struct buf *buf)
@@ -191,6 +209,7 @@ bufrelease(struct buf *buf)
 	if (!buf)
 		return;
 
-	free(buf->data);
+	if (!buf->grow)
+		free(buf->data);
 	free(buf);
 }
@@ -42,6 +42,12 @@ struct buf {
 	size_t size;	/* size of the string */
 	size_t asize;	/* allocated size (0 = volatile buffer) */
 	size_t unit;	/* reallocation unit size (0 = read-only buffer) */
+
+	/* external backing store: when set, `grow` is called instead of
+	 * realloc to make room for at least the given size, and has to
+	 * update `data` and `asize`; the data is never freed by the buffer */
+	int (*grow)(struct buf *, size_t);
+	void *store;
 };
 
 /* BUFPUTSL: optimized bufputs of a string literal */
@@ -54,6 +60,9 @@ int bufgrow(struct buf *, size_t);
 /* bufnew: allocation of a new buffer */
 struct buf *bufnew(size_t) __attribute__ ((malloc));
 
+/* bufinit_store: initialization of a buffer over an external store */
+void bufinit_store(struct buf *, size_t, int (*)(struct buf *, size_t), void *);
+
 /* bufnullterm: NUL-termination of the string array (making a C-string) */
 const char *bufcstr(const struct buf *);
 
@@ -0,0 +1,711 @@
+/* Emoji shortcodes and the characters they stand for, in a perfect
+ * hash table. Generated by `rake emoji` from emoji_names.txt */
+
+#define EMOJI_MAX_LENGTH 28
+#define EMOJI_BUCKETS 257
+#define EMOJI_SLOTS 642
+
+struct emoji {
+	const char *name;
+	const char *character;
+};
+
+static const unsigned short emoji_seeds[EMOJI_BUCKETS] = {
+	2, 1, 7, 1, 3, 3, 4, 3, 1, 5, 2, 5,
+	2, 1, 1, 0, 15, 1, 5, 5, 2, 3, 3, 1,
+	8, 2, 0, 0, 14, 1, 2, 2, 1, 2, 1, 5,
+	1, 5, 2, 0, 2, 2, 2, 9, 4, 9, 2, 3,
+	3, 17, 2, 0, 3, 3, 7, 1, 4, 1, 0, 4,
+	25, 5, 1, 5, 1, 1, 0, 1, 1, 4, 1, 8,
+	5, 0, 14, 1, 40, 2, 1, 1, 0, 1, 1, 0,
+	1, 3, 12, 3, 9, 3, 0, 0, 2, 8, 2, 0,
+	3, 4, 0, 13, 2, 4, 1, 1, 6, 2, 5, 4,
+	2, 1, 3, 4, 8, 1, 10, 3, 4, 6, 9, 1,
+	0, 3, 6, 3, 9, 7, 6, 6, 1, 10, 1, 1,
+	11, 3, 1, 1, 1, 0, 4, 0, 6, 1, 1, 3,
+	18, 5, 2, 4, 1, 3, 3, 8, 29, 1, 1, 1,
+	1, 0, 0, 4, 1, 2, 1, 3, 15, 0, 4, 4,
+	2, 2, 1, 1, 0, 2, 5, 1, 4, 13, 0, 0,
+	1, 2, 11, 0, 1, 2, 0, 0, 5, 4, 1, 2,
+	12, 1, 1, 1, 9, 2, 2, 1, 0, 1, 0, 2,
+	1, 0, 7, 2, 2, 2, 1, 4, 7, 2, 4, 1,
+	5, 1, 1, 1, 6, 0, 2, 1, 3, 8, 2, 2,
+	1, 3, 7, 8, 6, 0, 2, 5, 3, 3, 5, 3,
+	1, 3, 1, 18, 2, 2, 5, 12, 1, 3, 1, 3,
+	5, 1, 3, 2, 4,
+};
+
+static const struct emoji emoji_table[EMOJI_SLOTS] = {
+	{ "email", "\xE2\x9C\x89\xEF\xB8\x8F" },
+	{ "telephone", "\xE2\x98\x8E\xEF\xB8\x8F" },
+	{ "angry", "\xF0\x9F\x98\xA0" },
+	{ "chicken", "\xF0\x9F\x90\x94" },
+	{ "outbox_tray", "\xF0\x9F\x93\xA4" },
+	{ "satisfied", "\xF0\x9F\x98\x86" },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ "smiley", "\xF0\x9F\x98\x83" },
+	{ "up", "\xF0\x9F\x86\x99" },
+	{ "confetti_ball", "\xF0\x9F\x8E\x8A" },
+	{ "four_leaf_clover", "\xF0\x9F\x8D\x80" },
+	{ "hotdog", "\xF0\x9F\x8C\xAD" },
+	{ "skull", "\xF0\x9F\x92\x80" },
+	{ "grinning", "\xF0\x9F\x98\x80" },
+	{ "credit_card", "\xF0\x9F\x92\xB3" },
+	{ "broken_heart", "\xF0\x9F\x92\x94" },
+	{ "arrow_left", "\xE2\xAC\x85\xEF\xB8\x8F" },
+	{ "cloud", "\xE2\x98\x81\xEF\xB8\x8F" },
+	{ "sneezing_face", "\xF0\x9F\xA4\xA7" },
+	{ NULL, NULL },
+	{ "point_down", "\xF0\x9F\x91\x87" },
+	{ "brain", "\xF0\x9F\xA7\xA0" },
+	{ "alien", "\xF0\x9F\x91\xBD" },
+	{ "iphone", "\xF0\x9F\x93\xB1" },
+	{ "es", "\xF0\x9F\x87\xAA\xF0\x9F\x87\xB8" },
+	{ "runner", "\xF0\x9F\x8F\x83" },
+	{ NULL, NULL },
+	{ "unlock", "\xF0\x9F\x94\x93" },
+	{ NULL, NULL },
+	{ "arrow_up", "\xE2\xAC\x86\xEF\xB8\x8F" },
+	{ "mountain", "\xE2\x9B\xB0\xEF\xB8\x8F" },
+	{ "beetle", "\xF0\x9F\x90\x9E" },
+	{ "fist_oncoming", "\xF0\x9F\x91\x8A" },
+	{ "bookmark", "\xF0\x9F\x94\x96" },
+	{ "computer", "\xF0\x9F\x92\xBB" },
+	{ "punch", "\xF0\x9F\x91\x8A" },
+	{ NULL, NULL },
+	{ "briefcase", "\xF0\x9F\x92\xBC" },
+	{ NULL, NULL },
+	{ "anguished", "\xF0\x9F\x98\xA7" },
+	{ "beer", "\xF0\x9F\x8D\xBA" },
+	{ "sweat_drops", "\xF0\x9F\x92\xA6" },
+	{ "notes", "\xF0\x9F\x8E\xB6" },
+	{ "information_source", "\xE2\x84\xB9\xEF\xB8\x8F" },
+	{ "red_circle", "\xF0\x9F\x94\xB4" },
+	{ NULL, NULL },
+	{ "smiley_cat", "\xF0\x9F\x98\xBA" },
+	{ "sushi", "\xF0\x9F\x8D\xA3" },
+	{ "strawberry", "\xF0\x9F\x8D\x93" },
+	{ "eight_spoked_asterisk", "\xE2\x9C\xB3\xEF\xB8\x8F" },
+	{ "construction", "\xF0\x9F\x9A\xA7" },
+	{ "robot", "\xF0\x9F\xA4\x96" },
+	{ "small_red_triangle", "\xF0\x9F\x94\xBA" },
+	{ "heart_eyes_cat", "\xF0\x9F\x98\xBB" },
+	{ NULL, NULL },
+	{ "point_up_2", "\xF0\x9F\x91\x86" },
+	{ NULL, NULL },
+	{ "fuelpump", "\xE2\x9B\xBD" },
+	{ "inbox_tray", "\xF0\x9F\x93\xA5" },
+	{ "shirt", "\xF0\x9F\x91\x95" },
+	{ "stars", "\xF0\x9F\x8C\xA0" },
+	{ "green_heart", "\xF0\x9F\x92\x9A" },
+	{ "clap", "\xF0\x9F\x91\x8F" },
+	{ "dizzy", "\xF0\x9F\x92\xAB" },
+	{ "newspaper", "\xF0\x9F\x93\xB0" },
+	{ "house", "\xF0\x9F\x8F\xA0" },
+	{ "confused", "\xF0\x9F\x98\x95" },
+	{ "heart", "\xE2\x9D\xA4\xEF\xB8\x8F" },
+	{ NULL, NULL },
+	{ "hourglass", "\xE2\x8C\x9B" },
+	{ "church", "\xE2\x9B\xAA" },
+	{ "bread", "\xF0\x9F\x8D\x9E" },
+	{ NULL, NULL },
+	{ "mega", "\xF0\x9F\x93\xA3" },
+	{ "question", "\xE2\x9D\x93" },
+	{ "cookie", "\xF0\x9F\x8D\xAA" },
+	{ "monkey", "\xF0\x9F\x90\x92" },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ "pushpin", "\xF0\x9F\x93\x8C" },
+	{ "cactus", "\xF0\x9F\x8C\xB5" },
+	{ "headphones", "\xF0\x9F\x8E\xA7" },
+	{ "fearful", "\xF0\x9F\x98\xA8" },
+	{ "crossed_fingers", "\xF0\x9F\xA4\x9E" },
+	{ "arrows_counterclockwise", "\xF0\x9F\x94\x84" },
+	{ NULL, NULL },
+	{ "grey_exclamation", "\xE2\x9D\x95" },
+	{ "airplane", "\xE2\x9C\x88\xEF\xB8\x8F" },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ "hearts", "\xE2\x99\xA5\xEF\xB8\x8F" },
+	{ "cd", "\xF0\x9F\x92\xBF" },
+	{ "sailboat", "\xE2\x9B\xB5" },
+	{ "video_game", "\xF0\x9F\x8E\xAE" },
+	{ "book", "\xF0\x9F\x93\x96" },
+	{ "arrow_down", "\xE2\xAC\x87\xEF\xB8\x8F" },
+	{ "peach", "\xF0\x9F\x8D\x91" },
+	{ "evergreen_tree", "\xF0\x9F\x8C\xB2" },
+	{ "doughnut", "\xF0\x9F\x8D\xA9" },
+	{ "cool", "\xF0\x9F\x86\x92" },
+	{ NULL, NULL },
+	{ "triumph", "\xF0\x9F\x98\xA4" },
+	{ "muscle", "\xF0\x9F\x92\xAA" },
+	{ "grey_question", "\xE2\x9D\x94" },
+	{ "sweat_smile", "\xF0\x9F\x98\x85" },
+	{ "telescope", "\xF0\x9F\x94\xAD" },
+	{ "relieved", "\xF0\x9F\x98\x8C" },
+	{ "carrot", "\xF0\x9F\xA5\x95" },
+	{ "fries", "\xF0\x9F\x8D\x9F" },
+	{ "1st_place_medal", "\xF0\x9F\xA5\x87" },
+	{ NULL, NULL },
+	{ "no_entry_sign", "\xF0\x9F\x9A\xAB" },
+	{ "white_circle", "\xE2\x9A\xAA" },
+	{ "soccer", "\xE2\x9A\xBD" },
+	{ "eye", "\xF0\x9F\x91\x81\xEF\xB8\x8F" },
+	{ "hand", "\xE2\x9C\x8B" },
+	{ "open_book", "\xF0\x9F\x93\x96" },
+	{ "sun_with_face", "\xF0\x9F\x8C\x9E" },
+	{ "x", "\xE2\x9D\x8C" },
+	{ NULL, NULL },
+	{ "persevere", "\xF0\x9F\x98\xA3" },
+	{ "hash", "#\xEF\xB8\x8F\xE2\x83\xA3" },
+	{ "tv", "\xF0\x9F\x93\xBA" },
+	{ "lipstick", "\xF0\x9F\x92\x84" },
+	{ "heartbeat", "\xF0\x9F\x92\x93" },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ "heavy_plus_sign", "\xE2\x9E\x95" },
+	{ "snowman", "\xE2\x9B\x84" },
+	{ "pray", "\xF0\x9F\x99\x8F" },
+	{ "no_bell", "\xF0\x9F\x94\x95" },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ "loudspeaker", "\xF0\x9F\x93\xA2" },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ "cat", "\xF0\x9F\x90\xB1" },
+	{ "bird", "\xF0\x9F\x90\xA6" },
+	{ "hugs", "\xF0\x9F\xA4\x97" },
+	{ "floppy_disk", "\xF0\x9F\x92\xBE" },
+	{ NULL, NULL },
+	{ "chart_with_downwards_trend", "\xF0\x9F\x93\x89" },
+	{ "sob", "\xF0\x9F\x98\xAD" },
+	{ "thumbsup", "\xF0\x9F\x91\x8D" },
+	{ "flashlight", "\xF0\x9F\x94\xA6" },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ "ninja", "\xF0\x9F\xA5\xB7" },
+	{ "snake", "\xF0\x9F\x90\x8D" },
+	{ NULL, NULL },
+	{ "zero", "0\xEF\xB8\x8F\xE2\x83\xA3" },
+	{ "family", "\xF0\x9F\x91\xAA" },
+	{ "tada", "\xF0\x9F\x8E\x89" },
+	{ "running", "\xF0\x9F\x8F\x83" },
+	{ "cyclone", "\xF0\x9F\x8C\x80" },
+	{ NULL, NULL },
+	{ "beers", "\xF0\x9F\x8D\xBB" },
+	{ "rage", "\xF0\x9F\x98\xA1" },
+	{ NULL, NULL },
+	{ "chains", "\xE2\x9B\x93\xEF\xB8\x8F" },
+	{ "spades", "\xE2\x99\xA0\xEF\xB8\x8F" },
+	{ "grin", "\xF0\x9F\x98\x81" },
+	{ "bear", "\xF0\x9F\x90\xBB" },
+	{ "tangerine", "\xF0\x9F\x8D\x8A" },
+	{ "poop", "\xF0\x9F\x92\xA9" },
+	{ NULL, NULL },
+	{ "cupid", "\xF0\x9F\x92\x98" },
+	{ "fist_raised", "\xE2\x9C\x8A" },
+	{ NULL, NULL },
+	{ "label", "\xF0\x9F\x8F\xB7\xEF\xB8\x8F" },
+	{ "herb", "\xF0\x9F\x8C\xBF" },
+	{ NULL, NULL },
+	{ "bouquet", "\xF0\x9F\x92\x90" },
+	{ "partly_sunny", "\xE2\x9B\x85" },
+	{ "phone", "\xE2\x98\x8E\xEF\xB8\x8F" },
+	{ "heavy_check_mark", "\xE2\x9C\x94\xEF\xB8\x8F" },
+	{ "fr", "\xF0\x9F\x87\xAB\xF0\x9F\x87\xB7" },
+	{ "pencil", "\xF0\x9F\x93\x9D" },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ "no_mouth", "\xF0\x9F\x98\xB6" },
+	{ "unicorn", "\xF0\x9F\xA6\x84" },
+	{ "ghost", "\xF0\x9F\x91\xBB" },
+	{ NULL, NULL },
+	{ "hushed", "\xF0\x9F\x98\xAF" },
+	{ "cake", "\xF0\x9F\x8D\xB0" },
+	{ "electric_plug", "\xF0\x9F\x94\x8C" },
+	{ "sunny", "\xE2\x98\x80\xEF\xB8\x8F" },
+	{ "crescent_moon", "\xF0\x9F\x8C\x99" },
+	{ "gift", "\xF0\x9F\x8E\x81" },
+	{ "six", "6\xEF\xB8\x8F\xE2\x83\xA3" },
+	{ "page_facing_up", "\xF0\x9F\x93\x84" },
+	{ "sweat", "\xF0\x9F\x98\x93" },
+	{ "dog2", "\xF0\x9F\x90\x95" },
+	{ NULL, NULL },
+	{ "link", "\xF0\x9F\x94\x97" },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ "heavy_minus_sign", "\xE2\x9E\x96" },
+	{ NULL, NULL },
+	{ "speech_balloon", "\xF0\x9F\x92\xAC" },
+	{ "small_red_triangle_down", "\xF0\x9F\x94\xBB" },
+	{ "black_circle", "\xE2\x9A\xAB" },
+	{ "bee", "\xF0\x9F\x90\x9D" },
+	{ "straight_ruler", "\xF0\x9F\x93\x8F" },
+	{ "construction_worker", "\xF0\x9F\x91\xB7" },
+	{ "eyeglasses", "\xF0\x9F\x91\x93" },
+	{ "umbrella", "\xE2\x98\x94" },
+	{ "flushed", "\xF0\x9F\x98\xB3" },
+	{ "rabbit", "\xF0\x9F\x90\xB0" },
+	{ "eight", "8\xEF\xB8\x8F\xE2\x83\xA3" },
+	{ "us", "\xF0\x9F\x87\xBA\xF0\x9F\x87\xB8" },
+	{ "nauseated_face", "\xF0\x9F\xA4\xA2" },
+	{ "ballot_box_with_check", "\xE2\x98\x91\xEF\xB8\x8F" },
+	{ "mag", "\xF0\x9F\x94\x8D" },
+	{ "zipper_mouth_face", "\xF0\x9F\xA4\x90" },
+	{ "arrows_clockwise", "\xF0\x9F\x94\x83" },
+	{ NULL, NULL },
+	{ "trophy", "\xF0\x9F\x8F\x86" },
+	{ "burrito", "\xF0\x9F\x8C\xAF" },
+	{ "nine", "9\xEF\xB8\x8F\xE2\x83\xA3" },
+	{ "couple", "\xF0\x9F\x91\xAB" },
+	{ NULL, NULL },
+	{ "black_heart", "\xF0\x9F\x96\xA4" },
+	{ "egg", "\xF0\x9F\xA5\x9A" },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ "repeat", "\xF0\x9F\x94\x81" },
+	{ "wave", "\xF0\x9F\x91\x8B" },
+	{ "koala", "\xF0\x9F\x90\xA8" },
+	{ "tshirt", "\xF0\x9F\x91\x95" },
+	{ NULL, NULL },
+	{ "fist", "\xE2\x9C\x8A" },
+	{ "fire", "\xF0\x9F\x94\xA5" },
+	{ "desktop_computer", "\xF0\x9F\x96\xA5\xEF\xB8\x8F" },
+	{ NULL, NULL },
+	{ "necktie", "\xF0\x9F\x91\x94" },
+	{ "v", "\xE2\x9C\x8C\xEF\xB8\x8F" },
+	{ NULL, NULL },
+	{ "dash", "\xF0\x9F\x92\xA8" },
+	{ NULL, NULL },
+	{ "watch", "\xE2\x8C\x9A" },
+	{ "thumbsdown", "\xF0\x9F\x91\x8E" },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ "new", "\xF0\x9F\x86\x95" },
+	{ "two_hearts", "\xF0\x9F\x92\x95" },
+	{ "champagne", "\xF0\x9F\x8D\xBE" },
+	{ "hamburger", "\xF0\x9F\x8D\x94" },
+	{ "-1", "\xF0\x9F\x91\x8E" },
+	{ "hear_no_evil", "\xF0\x9F\x99\x89" },
+	{ "tm", "\xE2\x84\xA2\xEF\xB8\x8F" },
+	{ "large_orange_diamond", "\xF0\x9F\x94\xB6" },
+	{ "memo", "\xF0\x9F\x93\x9D" },
+	{ "snail", "\xF0\x9F\x90\x8C" },
+	{ "full_moon", "\xF0\x9F\x8C\x95" },
+	{ NULL, NULL },
+	{ "jack_o_lantern", "\xF0\x9F\x8E\x83" },
+	{ "e-mail", "\xF0\x9F\x93\xA7" },
+	{ "blush", "\xF0\x9F\x98\x8A" },
+	{ "speak_no_evil", "\xF0\x9F\x99\x8A" },
+	{ "red_car", "\xF0\x9F\x9A\x97" },
+	{ NULL, NULL },
+	{ "ng", "\xF0\x9F\x86\x96" },
+	{ "cow", "\xF0\x9F\x90\xAE" },
+	{ "it", "\xF0\x9F\x87\xAE\xF0\x9F\x87\xB9" },
+	{ "hospital", "\xF0\x9F\x8F\xA5" },
+	{ "thinking", "\xF0\x9F\xA4\x94" },
+	{ "bangbang", "\xE2\x80\xBC\xEF\xB8\x8F" },
+	{ "white_check_mark", "\xE2\x9C\x85" },
+	{ "spider", "\xF0\x9F\x95\xB7\xEF\xB8\x8F" },
+	{ "grapes", "\xF0\x9F\x8D\x87" },
+	{ "open_mouth", "\xF0\x9F\x98\xAE" },
+	{ "uk", "\xF0\x9F\x87\xAC\xF0\x9F\x87\xA7" },
+	{ NULL, NULL },
+	{ "moneybag", "\xF0\x9F\x92\xB0" },
+	{ NULL, NULL },
+	{ "maple_leaf", "\xF0\x9F\x8D\x81" },
+	{ "ramen", "\xF0\x9F\x8D\x9C" },
+	{ "pineapple", "\xF0\x9F\x8D\x8D" },
+	{ "popcorn", "\xF0\x9F\x8D\xBF" },
+	{ NULL, NULL },
+	{ "older_woman", "\xF0\x9F\x91\xB5" },
+	{ "jp", "\xF0\x9F\x87\xAF\xF0\x9F\x87\xB5" },
+	{ NULL, NULL },
+	{ "alarm_clock", "\xE2\x8F\xB0" },
+	{ "package", "\xF0\x9F\x93\xA6" },
+	{ NULL, NULL },
+	{ "dollar", "\xF0\x9F\x92\xB5" },
+	{ "point_up", "\xE2\x98\x9D\xEF\xB8\x8F" },
+	{ "droplet", "\xF0\x9F\x92\xA7" },
+	{ "revolving_hearts", "\xF0\x9F\x92\x9E" },
+	{ "heavy_exclamation_mark", "\xE2\x9D\x97" },
+	{ "on", "\xF0\x9F\x94\x9B" },
+	{ NULL, NULL },
+	{ "school", "\xF0\x9F\x8F\xAB" },
+	{ NULL, NULL },
+	{ "roll_eyes", "\xF0\x9F\x99\x84" },
+	{ "office", "\xF0\x9F\x8F\xA2" },
+	{ NULL, NULL },
+	{ "world_map", "\xF0\x9F\x97\xBA\xEF\xB8\x8F" },
+	{ "calendar", "\xF0\x9F\x93\x86" },
+	{ NULL, NULL },
+	{ "notebook", "\xF0\x9F\x93\x93" },
+	{ "wine_glass", "\xF0\x9F\x8D\xB7" },
+	{ "copyright", "\xC2\xA9\xEF\xB8\x8F" },
+	{ "exclamation", "\xE2\x9D\x97" },
+	{ "tomato", "\xF0\x9F\x8D\x85" },
+	{ "pencil2", "\xE2\x9C\x8F\xEF\xB8\x8F" },
+	{ "earth_asia", "\xF0\x9F\x8C\x8F" },
+	{ "ok_hand", "\xF0\x9F\x91\x8C" },
+	{ NULL, NULL },
+	{ "bulb", "\xF0\x9F\x92\xA1" },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ "handshake", "\xF0\x9F\xA4\x9D" },
+	{ "mailbox", "\xF0\x9F\x93\xAB" },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ "id", "\xF0\x9F\x86\x94" },
+	{ NULL, NULL },
+	{ "interrobang", "\xE2\x81\x89\xEF\xB8\x8F" },
+	{ "watermelon", "\xF0\x9F\x8D\x89" },
+	{ "de", "\xF0\x9F\x87\xA9\xF0\x9F\x87\xAA" },
+	{ "lock", "\xF0\x9F\x94\x92" },
+	{ "fallen_leaf", "\xF0\x9F\x8D\x82" },
+	{ "ship", "\xF0\x9F\x9A\xA2" },
+	{ "yum", "\xF0\x9F\x98\x8B" },
+	{ NULL, NULL },
+	{ "arrow_right", "\xE2\x9E\xA1\xEF\xB8\x8F" },
+	{ "dress", "\xF0\x9F\x91\x97" },
+	{ "bike", "\xF0\x9F\x9A\xB2" },
+	{ "soon", "\xF0\x9F\x94\x9C" },
+	{ "cop", "\xF0\x9F\x91\xAE" },
+	{ "hammer", "\xF0\x9F\x94\xA8" },
+	{ "honeybee", "\xF0\x9F\x90\x9D" },
+	{ "clipboard", "\xF0\x9F\x93\x8B" },
+	{ "tent", "\xE2\x9B\xBA" },
+	{ "earth_americas", "\xF0\x9F\x8C\x8E" },
+	{ "point_left", "\xF0\x9F\x91\x88" },
+	{ "microphone", "\xF0\x9F\x8E\xA4" },
+	{ "gear", "\xE2\x9A\x99\xEF\xB8\x8F" },
+	{ "innocent", "\xF0\x9F\x98\x87" },
+	{ "japanese_ogre", "\xF0\x9F\x91\xB9" },
+	{ "recycle", "\xE2\x99\xBB\xEF\xB8\x8F" },
+	{ "frog", "\xF0\x9F\x90\xB8" },
+	{ "top", "\xF0\x9F\x94\x9D" },
+	{ "eggplant", "\xF0\x9F\x8D\x86" },
+	{ NULL, NULL },
+	{ "star", "\xE2\xAD\x90" },
+	{ "books", "\xF0\x9F\x93\x9A" },
+	{ "whale", "\xF0\x9F\x90\xB3" },
+	{ NULL, NULL },
+	{ "tennis", "\xF0\x9F\x8E\xBE" },
+	{ "open_file_folder", "\xF0\x9F\x93\x82" },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ "zap", "\xE2\x9A\xA1" },
+	{ "door", "\xF0\x9F\x9A\xAA" },
+	{ "tiger", "\xF0\x9F\x90\xAF" },
+	{ "warning", "\xE2\x9A\xA0\xEF\xB8\x8F" },
+	{ "camera", "\xF0\x9F\x93\xB7" },
+	{ "toolbox", "\xF0\x9F\xA7\xB0" },
+	{ "raised_hands", "\xF0\x9F\x99\x8C" },
+	{ "free", "\xF0\x9F\x86\x93" },
+	{ "dart", "\xF0\x9F\x8E\xAF" },
+	{ "kr", "\xF0\x9F\x87\xB0\xF0\x9F\x87\xB7" },
+	{ "envelope", "\xE2\x9C\x89\xEF\xB8\x8F" },
+	{ "five", "5\xEF\xB8\x8F\xE2\x83\xA3" },
+	{ "syringe", "\xF0\x9F\x92\x89" },
+	{ "car", "\xF0\x9F\x9A\x97" },
+	{ "date", "\xF0\x9F\x93\x85" },
+	{ "taxi", "\xF0\x9F\x9A\x95" },
+	{ NULL, NULL },
+	{ "unamused", "\xF0\x9F\x98\x92" },
+	{ "turtle", "\xF0\x9F\x90\xA2" },
+	{ "scream", "\xF0\x9F\x98\xB1" },
+	{ NULL, NULL },
+	{ "yellow_heart", "\xF0\x9F\x92\x9B" },
+	{ NULL, NULL },
+	{ "raised_back_of_hand", "\xF0\x9F\xA4\x9A" },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ "snowflake", "\xE2\x9D\x84\xEF\xB8\x8F" },
+	{ "sunflower", "\xF0\x9F\x8C\xBB" },
+	{ NULL, NULL },
+	{ "dog", "\xF0\x9F\x90\xB6" },
+	{ "three", "3\xEF\xB8\x8F\xE2\x83\xA3" },
+	{ "chocolate_bar", "\xF0\x9F\x8D\xAB" },
+	{ "pizza", "\xF0\x9F\x8D\x95" },
+	{ "cold_sweat", "\xF0\x9F\x98\xB0" },
+	{ "hourglass_flowing_sand", "\xE2\x8F\xB3" },
+	{ "black_flag", "\xF0\x9F\x8F\xB4" },
+	{ NULL, NULL },
+	{ "kissing", "\xF0\x9F\x98\x97" },
+	{ "seedling", "\xF0\x9F\x8C\xB1" },
+	{ "ring", "\xF0\x9F\x92\x8D" },
+	{ "ok", "\xF0\x9F\x86\x97" },
+	{ "boat", "\xE2\x9B\xB5" },
+	{ "mushroom", "\xF0\x9F\x8D\x84" },
+	{ "cheese", "\xF0\x9F\xA7\x80" },
+	{ "two", "2\xEF\xB8\x8F\xE2\x83\xA3" },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ "baby", "\xF0\x9F\x91\xB6" },
+	{ "mask", "\xF0\x9F\x98\xB7" },
+	{ NULL, NULL },
+	{ "stuck_out_tongue_closed_eyes", "\xF0\x9F\x98\x9D" },
+	{ "new_moon", "\xF0\x9F\x8C\x91" },
+	{ "grimacing", "\xF0\x9F\x98\xAC" },
+	{ "hot_pepper", "\xF0\x9F\x8C\xB6\xEF\xB8\x8F" },
+	{ "cn", "\xF0\x9F\x87\xA8\xF0\x9F\x87\xB3" },
+	{ "dancer", "\xF0\x9F\x92\x83" },
+	{ "balloon", "\xF0\x9F\x8E\x88" },
+	{ "candy", "\xF0\x9F\x8D\xAC" },
+	{ "basketball", "\xF0\x9F\x8F\x80" },
+	{ NULL, NULL },
+	{ "cocktail", "\xF0\x9F\x8D\xB8" },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ "registered", "\xC2\xAE\xEF\xB8\x8F" },
+	{ "nerd_face", "\xF0\x9F\xA4\x93" },
+	{ "smiling_imp", "\xF0\x9F\x98\x88" },
+	{ NULL, NULL },
+	{ "police_officer", "\xF0\x9F\x91\xAE" },
+	{ "tulip", "\xF0\x9F\x8C\xB7" },
+	{ "chart_with_upwards_trend", "\xF0\x9F\x93\x88" },
+	{ NULL, NULL },
+	{ "sunglasses", "\xF0\x9F\x98\x8E" },
+	{ "flipper", "\xF0\x9F\x90\xAC" },
+	{ "guitar", "\xF0\x9F\x8E\xB8" },
+	{ "back", "\xF0\x9F\x94\x99" },
+	{ "neutral_face", "\xF0\x9F\x98\x90" },
+	{ "crown", "\xF0\x9F\x91\x91" },
+	{ "kiss", "\xF0\x9F\x92\x8B" },
+	{ "thought_balloon", "\xF0\x9F\x92\xAD" },
+	{ "stuck_out_tongue", "\xF0\x9F\x98\x9B" },
+	{ "butterfly", "\xF0\x9F\xA6\x8B" },
+	{ "expressionless", "\xF0\x9F\x98\x91" },
+	{ "medal_sports", "\xF0\x9F\x8F\x85" },
+	{ NULL, NULL },
+	{ "spaghetti", "\xF0\x9F\x8D\x9D" },
+	{ "sparkling_heart", "\xF0\x9F\x92\x96" },
+	{ "call_me_hand", "\xF0\x9F\xA4\x99" },
+	{ "cherry_blossom", "\xF0\x9F\x8C\xB8" },
+	{ "dolphin", "\xF0\x9F\x90\xAC" },
+	{ "tropical_drink", "\xF0\x9F\x8D\xB9" },
+	{ "gift_heart", "\xF0\x9F\x92\x9D" },
+	{ "footprints", "\xF0\x9F\x91\xA3" },
+	{ "football", "\xF0\x9F\x8F\x88" },
+	{ "volcano", "\xF0\x9F\x8C\x8B" },
+	{ "slightly_frowning_face", "\xF0\x9F\x99\x81" },
+	{ "wastebasket", "\xF0\x9F\x97\x91\xEF\xB8\x8F" },
+	{ "dragon", "\xF0\x9F\x90\x89" },
+	{ "baseball", "\xE2\x9A\xBE" },
+	{ NULL, NULL },
+	{ "disappointed", "\xF0\x9F\x98\x9E" },
+	{ "mouse", "\xF0\x9F\x90\xAD" },
+	{ "laughing", "\xF0\x9F\x98\x86" },
+	{ "seven", "7\xEF\xB8\x8F\xE2\x83\xA3" },
+	{ "paperclip", "\xF0\x9F\x93\x8E" },
+	{ "woman", "\xF0\x9F\x91\xA9" },
+	{ "crab", "\xF0\x9F\xA6\x80" },
+	{ "taco", "\xF0\x9F\x8C\xAE" },
+	{ "tophat", "\xF0\x9F\x8E\xA9" },
+	{ "game_die", "\xF0\x9F\x8E\xB2" },
+	{ "boy", "\xF0\x9F\x91\xA6" },
+	{ "cry", "\xF0\x9F\x98\xA2" },
+	{ "smile", "\xF0\x9F\x98\x84" },
+	{ "ant", "\xF0\x9F\x90\x9C" },
+	{ "panda_face", "\xF0\x9F\x90\xBC" },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ "fox_face", "\xF0\x9F\xA6\x8A" },
+	{ "star2", "\xF0\x9F\x8C\x9F" },
+	{ NULL, NULL },
+	{ "cowboy_hat_face", "\xF0\x9F\xA4\xA0" },
+	{ "metal", "\xF0\x9F\xA4\x98" },
+	{ "round_pushpin", "\xF0\x9F\x93\x8D" },
+	{ NULL, NULL },
+	{ "nail_care", "\xF0\x9F\x92\x85" },
+	{ "pill", "\xF0\x9F\x92\x8A" },
+	{ "musical_note", "\xF0\x9F\x8E\xB5" },
+	{ NULL, NULL },
+	{ "zzz", "\xF0\x9F\x92\xA4" },
+	{ "large_blue_diamond", "\xF0\x9F\x94\xB7" },
+	{ "wolf", "\xF0\x9F\x90\xBA" },
+	{ "bell", "\xF0\x9F\x94\x94" },
+	{ "heart_eyes", "\xF0\x9F\x98\x8D" },
+	{ NULL, NULL },
+	{ "triangular_flag_on_post", "\xF0\x9F\x9A\xA9" },
+	{ NULL, NULL },
+	{ "fireworks", "\xF0\x9F\x8E\x86" },
+	{ "upside_down_face", "\xF0\x9F\x99\x83" },
+	{ "checkered_flag", "\xF0\x9F\x8F\x81" },
+	{ "older_man", "\xF0\x9F\x91\xB4" },
+	{ "mag_right", "\xF0\x9F\x94\x8E" },
+	{ NULL, NULL },
+	{ "sparkles", "\xE2\x9C\xA8" },
+	{ "smirk", "\xF0\x9F\x98\x8F" },
+	{ "microscope", "\xF0\x9F\x94\xAC" },
+	{ NULL, NULL },
+	{ "no_entry", "\xE2\x9B\x94" },
+	{ "lemon", "\xF0\x9F\x8D\x8B" },
+	{ "ru", "\xF0\x9F\x87\xB7\xF0\x9F\x87\xBA" },
+	{ NULL, NULL },
+	{ "tired_face", "\xF0\x9F\x98\xAB" },
+	{ "diamonds", "\xE2\x99\xA6\xEF\xB8\x8F" },
+	{ "sparkle", "\xE2\x9D\x87\xEF\xB8\x8F" },
+	{ NULL, NULL },
+	{ "+1", "\xF0\x9F\x91\x8D" },
+	{ "speaking_head", "\xF0\x9F\x97\xA3\xEF\xB8\x8F" },
+	{ "clown_face", "\xF0\x9F\xA4\xA1" },
+	{ "white_flag", "\xF0\x9F\x8F\xB3\xEF\xB8\x8F" },
+	{ "eyes", "\xF0\x9F\x91\x80" },
+	{ "art", "\xF0\x9F\x8E\xA8" },
+	{ "walking", "\xF0\x9F\x9A\xB6" },
+	{ "love_letter", "\xF0\x9F\x92\x8C" },
+	{ NULL, NULL },
+	{ "coffee", "\xE2\x98\x95" },
+	{ "pout", "\xF0\x9F\x98\xA1" },
+	{ "man", "\xF0\x9F\x91\xA8" },
+	{ "one", "1\xEF\xB8\x8F\xE2\x83\xA3" },
+	{ "girl", "\xF0\x9F\x91\xA7" },
+	{ "face_with_thermometer", "\xF0\x9F\xA4\x92" },
+	{ "bug", "\xF0\x9F\x90\x9B" },
+	{ "open_hands", "\xF0\x9F\x91\x90" },
+	{ "o", "\xE2\xAD\x95" },
+	{ "bomb", "\xF0\x9F\x92\xA3" },
+	{ "lying_face", "\xF0\x9F\xA4\xA5" },
+	{ "see_no_evil", "\xF0\x9F\x99\x88" },
+	{ "rofl", "\xF0\x9F\xA4\xA3" },
+	{ NULL, NULL },
+	{ "anchor", "\xE2\x9A\x93" },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ "globe_with_meridians", "\xF0\x9F\x8C\x90" },
+	{ NULL, NULL },
+	{ "sleepy", "\xF0\x9F\x98\xAA" },
+	{ "magnet", "\xF0\x9F\xA7\xB2" },
+	{ "rainbow", "\xF0\x9F\x8C\x88" },
+	{ "bacon", "\xF0\x9F\xA5\x93" },
+	{ "pig", "\xF0\x9F\x90\xB7" },
+	{ "keycap_ten", "\xF0\x9F\x94\x9F" },
+	{ "train", "\xF0\x9F\x9A\x8B" },
+	{ "battery", "\xF0\x9F\x94\x8B" },
+	{ "money_mouth_face", "\xF0\x9F\xA4\x91" },
+	{ NULL, NULL },
+	{ "keyboard", "\xE2\x8C\xA8\xEF\xB8\x8F" },
+	{ "christmas_tree", "\xF0\x9F\x8E\x84" },
+	{ "apple", "\xF0\x9F\x8D\x8E" },
+	{ "earth_africa", "\xF0\x9F\x8C\x8D" },
+	{ "stuck_out_tongue_winking_eye", "\xF0\x9F\x98\x9C" },
+	{ "jeans", "\xF0\x9F\x91\x96" },
+	{ "confounded", "\xF0\x9F\x98\x96" },
+	{ "deciduous_tree", "\xF0\x9F\x8C\xB3" },
+	{ "four", "4\xEF\xB8\x8F\xE2\x83\xA3" },
+	{ "frowning", "\xF0\x9F\x98\xA6" },
+	{ NULL, NULL },
+	{ "lollipop", "\xF0\x9F\x8D\xAD" },
+	{ "facepunch", "\xF0\x9F\x91\x8A" },
+	{ "imp", "\xF0\x9F\x91\xBF" },
+	{ NULL, NULL },
+	{ "boom", "\xF0\x9F\x92\xA5" },
+	{ "bus", "\xF0\x9F\x9A\x8C" },
+	{ "file_folder", "\xF0\x9F\x93\x81" },
+	{ "octopus", "\xF0\x9F\x90\x99" },
+	{ "icecream", "\xF0\x9F\x8D\xA6" },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ "monkey_face", "\xF0\x9F\x90\xB5" },
+	{ "birthday", "\xF0\x9F\x8E\x82" },
+	{ "satellite", "\xF0\x9F\x93\xA1" },
+	{ "clubs", "\xE2\x99\xA3\xEF\xB8\x8F" },
+	{ "lion", "\xF0\x9F\xA6\x81" },
+	{ NULL, NULL },
+	{ "dizzy_face", "\xF0\x9F\x98\xB5" },
+	{ "rocket", "\xF0\x9F\x9A\x80" },
+	{ "100", "\xF0\x9F\x92\xAF" },
+	{ "collision", "\xF0\x9F\x92\xA5" },
+	{ NULL, NULL },
+	{ "fish", "\xF0\x9F\x90\x9F" },
+	{ "cherries", "\xF0\x9F\x8D\x92" },
+	{ "astonished", "\xF0\x9F\x98\xB2" },
+	{ "ocean", "\xF0\x9F\x8C\x8A" },
+	{ "worried", "\xF0\x9F\x98\x9F" },
+	{ "penguin", "\xF0\x9F\x90\xA7" },
+	{ NULL, NULL },
+	{ NULL, NULL },
+	{ "banana", "\xF0\x9F\x8D\x8C" },
+	{ "large_blue_circle", "\xF0\x9F\x94\xB5" },
+	{ NULL, NULL },
+	{ "kissing_heart", "\xF0\x9F\x98\x98" },
+	{ NULL, NULL },
+	{ "raised_hand", "\xE2\x9C\x8B" },
+	{ "joy", "\xF0\x9F\x98\x82" },
+	{ "vulcan_salute", "\xF0\x9F\x96\x96" },
+	{ "slightly_smiling_face", "\xF0\x9F\x99\x82" },
+	{ "palm_tree", "\xF0\x9F\x8C\xB4" },
+	{ NULL, NULL },
+	{ "horse", "\xF0\x9F\x90\xB4" },
+	{ "gb", "\xF0\x9F\x87\xAC\xF0\x9F\x87\xA7" },
+	{ "sleeping", "\xF0\x9F\x98\xB4" },
+	{ "gem", "\xF0\x9F\x92\x8E" },
+	{ "point_right", "\xF0\x9F\x91\x89" },
+	{ "green_apple", "\xF0\x9F\x8D\x8F" },
+	{ NULL, NULL },
+	{ "pear", "\xF0\x9F\x8D\x90" },
+	{ "avocado", "\xF0\x9F\xA5\x91" },
+	{ "drooling_face", "\xF0\x9F\xA4\xA4" },
+	{ "disappointed_relieved", "\xF0\x9F\x98\xA5" },
+	{ "shit", "\xF0\x9F\x92\xA9" },
+	{ "heavy_multiplication_x", "\xE2\x9C\x96\xEF\xB8\x8F" },
+	{ "anger", "\xF0\x9F\x92\xA2" },
+	{ "tea", "\xF0\x9F\x8D\xB5" },
+	{ "sos", "\xF0\x9F\x86\x98" },
+	{ "rose", "\xF0\x9F\x8C\xB9" },
+	{ "cat2", "\xF0\x9F\x90\x88" },
+	{ "corn", "\xF0\x9F\x8C\xBD" },
+	{ "hankey", "\xF0\x9F\x92\xA9" },
+	{ "end", "\xF0\x9F\x94\x9A" },
+	{ "blue_heart", "\xF0\x9F\x92\x99" },
+	{ "purple_heart", "\xF0\x9F\x92\x9C" },
+	{ "rotating_light", "\xF0\x9F\x9A\xA8" },
+	{ "key", "\xF0\x9F\x94\x91" },
+	{ "bar_chart", "\xF0\x9F\x93\x8A" },
+	{ NULL, NULL },
+	{ "weary", "\xF0\x9F\x98\xA9" },
+	{ "santa", "\xF0\x9F\x8E\x85" },
+	{ "hamster", "\xF0\x9F\x90\xB9" },
+	{ "wrench", "\xF0\x9F\x94\xA7" },
+	{ "wink", "\xF0\x9F\x98\x89" },
+	{ "scissors", "\xE2\x9C\x82\xEF\xB8\x8F" },
+	{ "heartpulse", "\xF0\x9F\x92\x97" },
+	{ NULL, NULL },
+};
+
+static unsigned int
+hash_emoji(const uint8_t *str, size_t len, unsigned int seed)
+{
+	unsigned int hash = 2166136261u ^ seed;
+	size_t i;
+
+	for (i = 0; i < len; ++i)
+		hash = (hash ^ str[i]) * 16777619u;
+
+	return hash;
+}
+
+static const struct emoji *
+find_emoji(const uint8_t *str, size_t len)
+{
+	const struct emoji *emoji;
+	unsigned int seed;
+
+	if (len > EMOJI_MAX_LENGTH)
+		return NULL;
+
+	seed = emoji_seeds[hash_emoji(str, len, 0) % EMOJI_BUCKETS];
+	emoji = &emoji_table[hash_emoji(str, len, seed) % EMOJI_SLOTS];
+
+	if (emoji->name && strncmp(emoji->name, (const char *)str, len) == 0 && emoji->name[len] == 0)
+		return emoji;
+
+	return NULL;
+}
@@ -2,5 +2,7 @@ require 'mkmf'
 
 $CFLAGS << ' -fvisibility=hidden'
 
+have_func('rb_ext_ractor_safe', 'ruby.h')
+
 dir_config('redcarpet')
 create_makefile('redcarpet')
@@ -69,6 +69,262 @@ static inline void escape_href(struct buf *ob, const uint8_t *source, size_t len
 	houdini_escape_href(ob, source, length);
 }
 
+/*************
+ * ALLOWLIST *
+ *************/
+
+/* the attributes whose value is a URL, and so gets its scheme checked */
+static const char *url_attributes[] = {
+	"href", "src", "cite", "action", "formaction", "poster", "background", "longdesc", "xlink:href"
+};
+
+static int
+name_is(const char *name, const uint8_t *data, size_t size)
+{
+	size_t i;
+
+	for (i = 0; i < size; ++i) {
+		if (name[i] == 0 || name[i] != tolower(data[i]))
+			return 0;
+	}
+
+	return name[i] == 0;
+}
+
+static const struct html_allowed_tag *
+allowed_tag(const struct html_allowlist *allowlist, const uint8_t *name, size_t size)
+{
+	size_t i;
+
+	for (i = 0; i < allowlist->count; ++i) {
+		if (name_is(allowlist->tags[i].name, name, size))
+			return &allowlist->tags[i];
+	}
+
+	return NULL;
+}
+
+static const char *
+allowed_attribute(const struct html_allowed_tag *tag, const uint8_t *name, size_t size)
+{
+	size_t i;
+
+	for (i = 0; i < tag->attribute_count; ++i) {
+		if (name_is(tag->attributes[i], name, size))
+			return tag->attributes[i];
+	}
+
+	return NULL;
+}
+
+/* a URL naming a scheme, even through an entity, must be a safe one */
+static int
+allowed_url(const char *attribute, const uint8_t *data, size_t size)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof(url_attributes) / sizeof(url_attributes[0]); ++i) {
+		if (strcmp(attribute, url_attributes[i]) == 0)
+			break;
+	}
+
+	if (i == sizeof(url_attributes) / sizeof(url_attributes[0]))
+		return 1;
+
+	while (size && *data <= ' ') {
+		data++;
+		size--;
+	}
+
+	for (i = 0; i < size && data[i] != '/' && data[i] != '?' && data[i] != '#'; ++i) {
+		if (data[i] == ':' || data[i] == '&')
+			return sd_autolink_issafe(data, size);
+	}
+
+	return 1;
+}
+
+/* writes out a tag with only what the allowlist keeps of it; returns
+ * its length, or 0 (and writes nothing) if it isn't a complete tag.
+ * A script or style left out is to be skipped up to its `end` */
+static size_t
+sanitize_tag(struct buf *ob, const uint8_t *data, size_t size,
+	const struct html_allowlist *allowlist, const char **end)
+{
+	size_t i = 1, name, name_end, value, value_end, mark = ob->size;
+	const struct html_allowed_tag *tag;
+	const char *attribute;
+	int closing = 0, self_closing = 0;
+
+	*end = NULL;
+
+	/* comments, doctypes and the like are left out */
+	if (size > 1 && (data[1] == '!' || data[1] == '?')) {
+		if (size > 3 && data[1] == '!' && data[2] == '-' && data[3] == '-') {
+			for (i = 4; i + 2 < size; ++i) {
+				if (data[i] == '-' && data[i + 1] == '-' && data[i + 2] == '>')
+					return i + 3;
+			}
+			return 0;
+		}
+
+		for (i = 2; i < size; ++i) {
+			if (data[i] == '>')
+				return i + 1;
+		}
+		return 0;
+	}
+
+	if (i < size && data[i] == '/') {
+		closing = 1;
+		i++;
+	}
+
+	if (i >= size || !isalpha(data[i]))
+		return 0;
+
+	name = i;
+	while (i < size && (isalnum(data[i]) || data[i] == '-'))
+		i++;
+	name_end = i;
+
+	tag = allowed_tag(allowlist, data + name, name_end - name);
+	if (tag) {
+		bufputc(ob, '<');
+		if (closing)
+			bufputc(ob, '/');
+		bufputs(ob, tag->name);
+	} else if (!closing && name_is("script", data + name, name_end - name)) {
+		*end = "</script";
+	} else if (!closing && name_is("style", data + name, name_end - name)) {
+		*end = "</style";
+	}
+
+	while (i < size && data[i] != '>') {
+		if (isspace(data[i]) || data[i] == '/') {
+			self_closing = (data[i] == '/');
+			i++;
+			continue;
+		}
+
+		self_closing = 0;
+
+		name = i;
+		while (i < size && !isspace(data[i]) && data[i] != '=' && data[i] != '/' && data[i] != '>')
+			i++;
+		name_end = i;
+
+		while (i < size && isspace(data[i]))
+			i++;
+
+		value = value_end = 0;
+		if (i < size && data[i] == '=') {
+			i++;
+			while (i < size && isspace(data[i]))
+				i++;
+
+			if (i < size && (data[i] == '"' || data[i] == '\'')) {
+				uint8_t quote = data[i++];
+
+				value = i;
+				while (i < size && data[i] != quote)
+					i++;
+				if (i == size)
+					break;
+				value_end = i++;
+			} else {
+				value = i;
+				while (i < size && !isspace(data[i]) && data[i] != '>')
+					i++;
+				value_end = i;
+			}
+		}
+
+		if (!tag || closing)
+			continue;
+
+		attribute = allowed_attribute(tag, data + name, name_end - name);
+		if (!attribute || !allowed_url(attribute, data + value, value_end - value))
+			continue;
+
+		bufputc(ob, ' ');
+		bufputs(ob, attribute);
+		if (value) {
+			BUFPUTSL(ob, "=\"");
+			for (; value < value_end; ++value) {
+				switch (data[value]) {
+				case '"': BUFPUTSL(ob, "&quot;"); break;
+				case '<': BUFPUTSL(ob, "&lt;"); break;
+				case '>': BUFPUTSL(ob, "&gt;"); break;
+				default: bufputc(ob, data[value]);
+				}
+			}
+			bufputc(ob, '"');
+		}
+	}
+
+	if (i >= size) {
+		ob->size = mark;
+		*end = NULL;
+		return 0;
+	}
+
+	if (tag) {
+		if (self_closing && !closing)
+			bufputc(ob, '/');
+		bufputc(ob, '>');
+	} else if (self_closing) {
+		*end = NULL;
+	}
+
+	return i + 1;
+}
+
+/* raw HTML is taken apart into tags and text; the tags are written
+ * out again with what the allowlist keeps of them, and no `<` of the
+ * text is left to start one that wasn't checked */
+static void
+sanitize_html(struct buf *ob, const uint8_t *data, size_t size, const struct html_allowlist *allowlist)
+{
+	const char *end;
+	size_t i = 0, org, len, end_len;
+
+	while (i < size) {
+		org = i;
+		while (i < size && data[i] != '<')
+			i++;
+
+		bufput(ob, data + org, i - org);
+		if (i >= size)
+			break;
+
+		len = sanitize_tag(ob, data + i, size - i, allowlist, &end);
+		if (!len) {
+			BUFPUTSL(ob, "&lt;");
+			i++;
+			continue;
+		}
+
+		i += len;
+		if (end) {
+			end_len = strlen(end);
+			while (i + end_len <= size && !name_is(end, data + i, end_len))
+				i++;
+			if (i + end_len > size)
+				i = size;
+		}
+	}
+}
+
+/* the URL of a link or image, as the renderer may want it rewritten */
+static inline void put_href(struct buf *ob, const struct buf *link, int image, struct html_renderopt *options, void *opaque)
+{
+	if (options->link_url)
+		options->link_url(ob, link, image, opaque);
+	else
+		escape_href(ob, link->data, link->size);
+}
+
 /********************
  * GENERIC RENDERER *
  ********************/
@@ -86,9 +342,12 @@ rndr_autolink(struct buf *ob, const struct buf *link, enum mkd_autolink type, vo
 		return 0;
 
 	BUFPUTSL(ob, "<a href=\"");
-	if (type == MKDA_EMAIL)
+	if (type == MKDA_EMAIL) {
 		BUFPUTSL(ob, "mailto:");
-	escape_href(ob, link->data, link->size);
+		escape_href(ob, link->data, link->size);
+	} else {
+		put_href(ob, link, 0, options, opaque);
+	}
 
 	if (options->link_attributes) {
 		bufputc(ob, '\"');
@@ -264,60 +523,81 @@ rndr_linebreak(struct buf *ob, void *opaque)
 	return 1;
 }
 
-char *header_anchor(const struct buf *buffer)
+/* header_anchor • writes the anchor of a header's text */
+/*	the text is lower-cased with its spaces turned into dashes and the
+ *	STRIPPED_CHARS left out, a stripped char between two spaces going
+ *	along with one of them. When a '>' comes before any '<', the text
+ *	is first split on the angle brackets and only every other piece is
+ *	kept, which drops the tags most of the time */
+void
+header_anchor(struct buf *ob, const struct buf *text)
 {
-	size_t i, j, k, size = buffer->size;
+	const uint8_t *lt, *gt;
+	struct buf *raw;
+	size_t i, size, piece;
+	int in_piece, seen;
+	uint8_t c;
+
+	if (!text || !text->size)
+		return;
 
-	char text[size];
-	strcpy(text, bufcstr(buffer));
+	/* the text ends at a NUL, as it used to be handled as a C string */
+	size = text->size;
+	if ((gt = memchr(text->data, '\0', size)) != NULL)
+		size = gt - text->data;
 
-	char raw_string[size];
+	raw = bufnew(64);
+	if (!raw)
+		return;
 
-	/* Strip down the inline HTML markup if needed */
-	if (strchr(text, '<') < strchr(text, '>')) {
-		char* part = strtok(text, "<>");
+	lt = memchr(text->data, '<', size);
+	gt = memchr(text->data, '>', size);
 
-		/* Once every two times, the yielded token is the
-		   content of a HTML tag so we don't need to copy it */
-		for (k = 0; part != NULL; k++) {
-			if (k == 0)
-				strcpy(raw_string, part);
-			else if (k % 2 == 0)
-				strcat(raw_string, part);
+	if (gt && (!lt || lt < gt)) {
+		for (i = 0, piece = 0, in_piece = 0, seen = 0; i < size; ++i) {
+			c = text->data[i];
 
-			part = strtok(NULL, "<>");
-		}
+			if (c == '<' || c == '>') {
+				in_piece = 0;
+				continue;
+			}
+
+			if (!in_piece) {
+				if (seen) piece++;
+				seen = in_piece = 1;
+			}
 
-		size = strlen(raw_string);
+			if (piece % 2 == 0)
+				bufputc(raw, c);
+		}
 	} else {
-		strcpy(raw_string, text);
+		bufput(raw, text->data, size);
 	}
 
-	char* heading = malloc(size * sizeof(char));
+	size = raw->size;
 
-	/* Remove extra white spaces and lower case all
-	   characters ; also replace spaces with dashes */
-	for (i = 0, j = 0; i <= size; ++i) {
-		/* Collapse a stripped char surrounded by spaces
-		   to a single space (e.g. " + " -> " ") */
-		if (raw_string[i-1] == ' ' && raw_string[i+1] == ' '
-		    && STRIPPED_CHAR(raw_string[i]) && (i+1) < size)
+#define RAW(i) ((i) < size ? raw->data[i] : 0)
+	for (i = 0; i <= size; ++i) {
+		/* collapse a stripped char surrounded by spaces
+		 * to a single space (e.g. " + " -> " ") */
+		if (i > 0 && RAW(i - 1) == ' ' && RAW(i + 1) == ' ' &&
+			i + 1 < size && STRIPPED_CHAR(RAW(i)))
 			i = i + 2;
 
-		/* Remove double spaces and stripped out chars */
-		if ((raw_string[i] == ' ' && raw_string[i+1] == ' ')
-		   || (STRIPPED_CHAR(raw_string[i]) && i < size))
+		c = RAW(i);
+
+		/* remove double spaces and stripped out chars */
+		if ((c == ' ' && RAW(i + 1) == ' ') || (i < size && STRIPPED_CHAR(c)))
 			continue;
 
-		if (raw_string[i] == ' ')
-			heading[j] = '-';
-		else
-			heading[j] = tolower(raw_string[i]);
+		if (i >= size)
+			break;
 
-		j++;
+		bufputc(ob, c == ' ' ? '-' : (c < 0x80 ? tolower(c) : c));
 	}
+#undef RAW
 
-	return heading;
+	bufrelease(raw);
 }
 
 static void
@@ -328,9 +608,11 @@ rndr_header(struct buf *ob, const struct buf *text, int level, void *opaque)
 	if (ob->size)
 		bufputc(ob, '\n');
 
-	if ((options->flags & HTML_TOC) && (level <= options->toc_data.nesting_level))
-		bufprintf(ob, "<h%d id=\"%s\">", level, header_anchor(text));
-	else
+	if ((options->flags & HTML_TOC) && (level <= options->toc_data.nesting_level)) {
+		bufprintf(ob, "<h%d id=\"", level);
+		header_anchor(ob, text);
+		BUFPUTSL(ob, "\">");
+	} else
 		bufprintf(ob, "<h%d>", level);
 
 	if (text) bufput(ob, text->data, text->size);
@@ -348,7 +630,7 @@ rndr_link(struct buf *ob, const struct buf *link, const struct buf *title, const
 	BUFPUTSL(ob, "<a href=\"");
 
 	if (link && link->size)
-		escape_href(ob, link->data, link->size);
+		put_href(ob, link, 0, options, opaque);
 
 	if (title && title->size) {
 		BUFPUTSL(ob, "\" title=\"");
@@ -460,7 +742,10 @@ rndr_raw_block(struct buf *ob, const struct buf *text, void *opaque)
 	if (ob->size)
 		bufputc(ob, '\n');
 
-	bufput(ob, text->data + org, size - org);
+	if (options->allowlist)
+		sanitize_html(ob, text->data + org, size - org, options->allowlist);
+	else
+		bufput(ob, text->data + org, size - org);
 	bufputc(ob, '\n');
 }
 
@@ -491,7 +776,8 @@ rndr_image(struct buf *ob, const struct buf *link, const struct buf *title, cons
 		return 0;
 
 	BUFPUTSL(ob, "<img src=\"");
-	escape_href(ob, link->data, link->size);
+	if (link && link->size)
+		put_href(ob, link, 1, options, opaque);
 	BUFPUTSL(ob, "\" alt=\"");
 
 	if (alt && alt->size)
@@ -532,7 +818,10 @@ rndr_raw_html(struct buf *ob, const struct buf *text, void *opaque)
 		sdhtml_is_tag(text->data, text->size, "img"))
 		return 1;
 
-	bufput(ob, text->data, text->size);
+	if (options->allowlist)
+		sanitize_html(ob, text->data, text->size, options->allowlist);
+	else
+		bufput(ob, text->data, text->size);
 	return 1;
 }
 
@@ -549,6 +838,26 @@ rndr_table(struct buf *ob, const struct buf *header, const struct buf *body, voi
 	BUFPUTSL(ob, "</tbody></table>\n");
 }
 
+static void
+rndr_table_open(struct buf *ob, int flags, void *opaque)
+{
+	if (flags & MKD_TABLE_HEADER) {
+		if (ob->size) bufputc(ob, '\n');
+		BUFPUTSL(ob, "<table><thead>\n");
+	} else {
+		BUFPUTSL(ob, "<tbody>\n");
+	}
+}
+
+static void
+rndr_table_close(struct buf *ob, int flags, void *opaque)
+{
+	if (flags & MKD_TABLE_HEADER)
+		BUFPUTSL(ob, "</thead>");
+	else
+		BUFPUTSL(ob, "</tbody></table>\n");
+}
+
 static void
 rndr_tablerow(struct buf *ob, const struct buf *text, void *opaque)
 {
@@ -665,6 +974,33 @@ rndr_footnote_ref(struct buf *ob, unsigned int num, void *opaque)
 	return 1;
 }
 
+static int
+rndr_emoji(struct buf *ob, const struct buf *name, const struct buf *character, void *opaque)
+{
+	struct html_renderopt *options = opaque;
+	const char *image = options->emoji_image, *mark;
+
+	if (!image) {
+		bufput(ob, character->data, character->size);
+		return 1;
+	}
+
+	BUFPUTSL(ob, "<img class=\"emoji\" src=\"");
+	while ((mark = strstr(image, "%s")) != NULL) {
+		escape_href(ob, (const uint8_t *)image, mark - image);
+		escape_href(ob, name->data, name->size);
+		image = mark + 2;
+	}
+	escape_href(ob, (const uint8_t *)image, strlen(image));
+
+	BUFPUTSL(ob, "\" alt=\"");
+	bufput(ob, character->data, character->size);
+	BUFPUTSL(ob, "\" title=\":");
+	escape_html(ob, name->data, name->size);
+	bufputs(ob, USE_XHTML(options) ? ":\"/>" : ":\">");
+	return 1;
+}
+
 static void
 toc_header(struct buf *ob, const struct buf *text, int level, void *opaque)
 {
@@ -694,7 +1030,9 @@ toc_header(struct buf *ob, const struct buf *text, int level, void *opaque)
 			BUFPUTSL(ob,"</li>\n<li>\n");
 		}
 
-		bufprintf(ob, "<a href=\"#%s\">", header_anchor(text));
+		BUFPUTSL(ob, "<a href=\"#");
+		header_anchor(ob, text);
+		BUFPUTSL(ob, "\">");
 
 		if (text) {
 			if (options->flags & HTML_ESCAPE)
@@ -726,6 +1064,180 @@ toc_finalize(struct buf *ob, void *opaque)
 	}
 }
 
+/* sdhtml_header_text • the text of a header rendered by the outline
+ * callbacks, without its tags and with the characters they escaped */
+void
+sdhtml_header_text(struct buf *ob, const struct buf *text)
+{
+	static const char *escapes[][2] = {
+		{ "&quot;", "\"" }, { "&amp;", "&" }, { "&#39;", "'" },
+		{ "&#47;", "/" }, { "&lt;", "<" }, { "&gt;", ">" }
+	};
+
+	const uint8_t *data = text->data;
+	size_t i = 0, org, size = text->size, e, len;
+
+	while (i < size) {
+		org = i;
+		while (i < size && data[i] != '<' && data[i] != '&')
+			i++;
+
+		bufput(ob, data + org, i - org);
+		if (i >= size)
+			break;
+
+		if (data[i] == '<') {
+			const uint8_t *end;
+
+			/* a '<' from the text rather than a tag stays */
+			if (i + 1 < size && (isalpha(data[i + 1]) || data[i + 1] == '/') &&
+				(end = memchr(data + i, '>', size - i)) != NULL) {
+				i = end - data + 1;
+				continue;
+			}
+		} else {
+			for (e = 0; e < sizeof(escapes) / sizeof(escapes[0]); ++e) {
+				len = strlen(escapes[e][0]);
+				if (i + len <= size && memcmp(data + i, escapes[e][0], len) == 0)
+					break;
+			}
+
+			if (e < sizeof(escapes) / sizeof(escapes[0])) {
+				bufputs(ob, escapes[e][1]);
+				i += len;
+				continue;
+			}
+		}
+
+		bufputc(ob, data[i++]);
+	}
+}
+
+/* the StripDown renderer keeps the text of every element and
+ * drops the markup around it */
+static void
+strip_text(struct buf *ob, const struct buf *text, void *opaque)
+{
+	if (text)
+		bufput(ob, text->data, text->size);
+}
+
+static void
+strip_line(struct buf *ob, const struct buf *text, void *opaque)
+{
+	if (text)
+		bufput(ob, text->data, text->size);
+	bufputc(ob, '\n');
+}
+
+static void
+strip_blockcode(struct buf *ob, const struct buf *text, const struct buf *lang, void *opaque)
+{
+	strip_text(ob, text, opaque);
+}
+
+static void
+strip_header(struct buf *ob, const struct buf *text, int level, void *opaque)
+{
+	strip_line(ob, text, opaque);
+}
+
+static void
+strip_list(struct buf *ob, const struct buf *text, int flags, void *opaque)
+{
+	strip_text(ob, text, opaque);
+}
+
+static void
+strip_table(struct buf *ob, const struct buf *header, const struct buf *body, void *opaque)
+{
+	strip_text(ob, header, opaque);
+	strip_text(ob, body, opaque);
+}
+
+static void
+strip_tablerow(struct buf *ob, const struct buf *text, void *opaque)
+{
+	/* every cell is followed by a tab, but the last one */
+	if (text && text->size)
+		bufput(ob, text->data, text->size - 1);
+	bufputc(ob, '\n');
+}
+
+static void
+strip_tablecell(struct buf *ob, const struct buf *text, int flags, void *opaque)
+{
+	strip_text(ob, text, opaque);
+	bufputc(ob, '\t');
+}
+
+static void
+strip_footnote_def(struct buf *ob, const struct buf *text, unsigned int num, void *opaque)
+{
+	strip_text(ob, text, opaque);
+}
+
+static int
+strip_span(struct buf *ob, const struct buf *text, void *opaque)
+{
+	if (!text)
+		return 0;
+
+	bufput(ob, text->data, text->size);
+	return 1;
+}
+
+static int
+strip_quote(struct buf *ob, const struct buf *text, void *opaque)
+{
+	bufputc(ob, '"');
+	strip_text(ob, text, opaque);
+	bufputc(ob, '"');
+	return 1;
+}
+
+static int
+strip_autolink(struct buf *ob, const struct buf *link, enum mkd_autolink type, void *opaque)
+{
+	return strip_span(ob, link, opaque);
+}
+
+static int
+strip_link(struct buf *ob, const struct buf *link, const struct buf *title, const struct buf *content, void *opaque)
+{
+	strip_text(ob, content, opaque);
+	BUFPUTSL(ob, " (");
+	strip_text(ob, link, opaque);
+	bufputc(ob, ')');
+	return 1;
+}
+
+static int
+strip_image(struct buf *ob, const struct buf *link, const struct buf *title, const struct buf *alt, void *opaque)
+{
+	if (alt) {
+		bufput(ob, alt->data, alt->size);
+		bufputc(ob, ' ');
+	}
+
+	strip_text(ob, link, opaque);
+	return 1;
+}
+
+static int
+strip_footnote_ref(struct buf *ob, unsigned int num, void *opaque)
+{
+	bufprintf(ob, "[%d]", num);
+	return 1;
+}
+
+static int
+strip_emoji(struct buf *ob, const struct buf *name, const struct buf *character, void *opaque)
+{
+	bufput(ob, character->data, character->size);
+	return 1;
+}
+
 void
 sdhtml_toc_renderer(struct sd_callbacks *callbacks, struct html_renderopt *options, unsigned int render_flags)
 {
@@ -759,6 +1271,7 @@ sdhtml_toc_renderer(struct sd_callbacks *callbacks, struct html_renderopt *optio
 		rndr_strikethrough,
 		rndr_superscript,
 		rndr_footnote_ref,
+		rndr_emoji,
 
 		NULL,
 		NULL,
@@ -773,6 +1286,19 @@ sdhtml_toc_renderer(struct sd_callbacks *callbacks, struct html_renderopt *optio
 	memcpy(callbacks, &cb_default, sizeof(struct sd_callbacks));
 }
 
+/* the outline callbacks only render the text of headers, the way the
+ * TOC does so that their anchors come out the same */
+void
+sdhtml_outline_renderer(struct sd_callbacks *callbacks, struct html_renderopt *options)
+{
+	sdhtml_toc_renderer(callbacks, options, 0);
+
+	callbacks->header = NULL;
+	callbacks->footnotes = NULL;
+	callbacks->footnote_def = NULL;
+	callbacks->doc_footer = NULL;
+}
+
 void
 sdhtml_renderer(struct sd_callbacks *callbacks, struct html_renderopt *options, unsigned int render_flags)
 {
@@ -806,12 +1332,16 @@ sdhtml_renderer(struct sd_callbacks *callbacks, struct html_renderopt *options,
 		rndr_strikethrough,
 		rndr_superscript,
 		rndr_footnote_ref,
+		rndr_emoji,
 
 		NULL,
 		rndr_normal_text,
 
 		NULL,
 		NULL,
+
+		rndr_table_open,
+		rndr_table_close,
 	};
 
 	/* Prepare the options pointer */
@@ -833,3 +1363,49 @@ sdhtml_renderer(struct sd_callbacks *callbacks, struct html_renderopt *options,
 	if (render_flags & HTML_SKIP_HTML || render_flags & HTML_ESCAPE)
 		callbacks->blockhtml = NULL;
 }
+
+void
+sdhtml_stripdown_renderer(struct sd_callbacks *callbacks, struct html_renderopt *options)
+{
+	static const struct sd_callbacks cb_default = {
+		strip_blockcode,
+		strip_text,
+		strip_text,
+		strip_header,
+		NULL,
+		strip_list,
+		strip_list,
+		strip_line,
+		strip_table,
+		strip_tablerow,
+		strip_tablecell,
+		strip_text,
+		strip_footnote_def,
+
+		strip_autolink,
+		strip_span,
+		strip_span,
+		strip_span,
+		strip_span,
+		strip_span,
+		strip_quote,
+		strip_image,
+		NULL,
+		strip_link,
+		strip_span,
+		strip_span,
+		strip_span,
+		strip_span,
+		strip_footnote_ref,
+		strip_emoji,
+
+		NULL,
+		NULL,
+
+		NULL,
+		NULL,
+	};
+
+	memset(options, 0x0, sizeof(struct html_renderopt));
+	memcpy(callbacks, &cb_default, sizeof(struct sd_callbacks));
+}
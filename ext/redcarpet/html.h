@@ -25,6 +25,18 @@
 extern "C" {
 #endif
 
+/* the tags, with their attributes, raw HTML is allowed to keep */
+struct html_allowed_tag {
+	const char *name;
+	size_t attribute_count;
+	const char **attributes;
+};
+
+struct html_allowlist {
+	size_t count;
+	const struct html_allowed_tag *tags;
+};
+
 struct html_renderopt {
 	struct {
 		int current_level;
@@ -36,6 +48,13 @@ struct html_renderopt {
 
 	/* extra callbacks */
 	void (*link_attributes)(struct buf *ob, const struct buf *url, void *self);
+	void (*link_url)(struct buf *ob, const struct buf *url, int image, void *self);
+
+	/* when set, raw HTML only keeps what it allows */
+	const struct html_allowlist *allowlist;
+
+	/* when set, emoji are images; `%s` in it stands for the shortcode */
+	const char *emoji_image;
 };
 
 typedef enum {
@@ -67,11 +86,21 @@ sdhtml_renderer(struct sd_callbacks *callbacks, struct html_renderopt *options_p
 extern void
 sdhtml_toc_renderer(struct sd_callbacks *callbacks, struct html_renderopt *options_ptr, unsigned int render_flags);
 
+extern void
+sdhtml_outline_renderer(struct sd_callbacks *callbacks, struct html_renderopt *options_ptr);
+
+extern void
+sdhtml_header_text(struct buf *ob, const struct buf *text);
+
+extern void
+sdhtml_stripdown_renderer(struct sd_callbacks *callbacks, struct html_renderopt *options_ptr);
+
 extern void
 sdhtml_smartypants(struct buf *ob, const uint8_t *text, size_t size);
 
 /* header method used internally in Redcarpet */
-char *header_anchor(const struct buf *buffer);
+void
+header_anchor(struct buf *ob, const struct buf *text);
 
 #define STRIPPED_CHARS "&+$,/:;=?@\"#{}|^~[]`\\*()%.!'"
 #define STRIPPED_CHAR(x) (strchr(STRIPPED_CHARS, x) != NULL)
@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2011, Vicent Marti
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "markdown.h"
+#include "man.h"
+#include <string.h>
+
+#define ESCAPE_GROW_FACTOR(x) (((x) * 12) / 10)
+
+/**
+ * Roff escapes:
+ *
+ * -  --> \-     a plain hyphen may be typeset as a dash or break a line
+ * \  --> \e     the escape character itself
+ * .  --> \&.    only at the start of a line, where it begins a request
+ * '  --> \&'    only at the start of a line, likewise
+ *
+ */
+static const char ROFF_ESCAPE_TABLE[] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 4, 0, 0, 0, 0, 0, 1, 3, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+static const char *ROFF_ESCAPES[] = {
+	"",
+	"\\-",
+	"\\e",
+	"\\&.",
+	"\\&'",
+};
+
+/* same set as Ruby's String#strip */
+#define STRIP_SPACE(c) ((c) == ' ' || (c) == '\0' || ((c) >= '\t' && (c) <= '\r'))
+
+/* strip • narrows data[*beg..size) to its text without surrounding whitespace */
+static size_t
+strip(const uint8_t *data, size_t size, size_t *beg)
+{
+	size_t i = 0;
+
+	while (size > 0 && STRIP_SPACE(data[size - 1]))
+		size--;
+
+	while (i < size && STRIP_SPACE(data[i]))
+		i++;
+
+	*beg = i;
+	return size;
+}
+
+/* escape_roff • escapes text for roff, dropping the whitespace around it */
+static void
+escape_roff(struct buf *ob, const uint8_t *src, size_t size)
+{
+	size_t i, beg, org, esc = 0;
+	int bol = (ob->size == 0 || ob->data[ob->size - 1] == '\n');
+
+	size = strip(src, size, &beg);
+	bufgrow(ob, ob->size + ESCAPE_GROW_FACTOR(size - beg));
+
+	i = beg;
+	while (i < size) {
+		org = i;
+		while (i < size && (esc = ROFF_ESCAPE_TABLE[src[i]]) == 0)
+			i++;
+
+		if (i > org)
+			bufput(ob, src + org, i - org);
+
+		if (i >= size)
+			break;
+
+		/* dots and quotes only need care where a line starts */
+		if (esc >= 3 && !(i > beg ? src[i - 1] == '\n' : bol))
+			bufputc(ob, src[i]);
+		else
+			bufputs(ob, ROFF_ESCAPES[esc]);
+
+		i++;
+	}
+}
+
+/********************
+ * BLOCK CALLBACKS *
+ ********************/
+
+static void
+rndr_blockcode(struct buf *ob, const struct buf *text, const struct buf *lang, void *opaque)
+{
+	BUFPUTSL(ob, "\n.nf\n");
+	if (text) escape_roff(ob, text->data, text->size);
+	BUFPUTSL(ob, "\n.fi\n");
+}
+
+static void
+rndr_header(struct buf *ob, const struct buf *text, int level, void *opaque)
+{
+	switch (level) {
+	case 1: BUFPUTSL(ob, "\n.TH "); break;
+	case 2: BUFPUTSL(ob, "\n.SH "); break;
+	case 3: BUFPUTSL(ob, "\n.SS "); break;
+	default: return; /* roff has no deeper sections */
+	}
+
+	if (text) bufput(ob, text->data, text->size);
+	bufputc(ob, '\n');
+}
+
+static void
+rndr_list(struct buf *ob, const struct buf *text, int flags, void *opaque)
+{
+	if (flags & MKD_LIST_ORDERED)
+		BUFPUTSL(ob, "\n\n.nr step 0 1\n");
+	else
+		BUFPUTSL(ob, "\n.\n");
+
+	if (text) bufput(ob, text->data, text->size);
+	bufputc(ob, '\n');
+}
+
+static void
+rndr_listitem(struct buf *ob, const struct buf *text, int flags, void *opaque)
+{
+	if (flags & MKD_LIST_ORDERED)
+		BUFPUTSL(ob, ".IP \\n+[step]\n");
+	else
+		BUFPUTSL(ob, ".IP \\[bu] 2 \n");
+
+	if (text) {
+		size_t beg, end = strip(text->data, text->size, &beg);
+		bufput(ob, text->data + beg, end - beg);
+	}
+	bufputc(ob, '\n');
+}
+
+static void
+rndr_paragraph(struct buf *ob, const struct buf *text, void *opaque)
+{
+	BUFPUTSL(ob, "\n.TP\n");
+	if (text) bufput(ob, text->data, text->size);
+	bufputc(ob, '\n');
+}
+
+/*******************
+ * SPAN CALLBACKS *
+ *******************/
+
+static int
+rndr_codespan(struct buf *ob, const struct buf *text, void *opaque)
+{
+	rndr_blockcode(ob, text, NULL, opaque);
+	return 1;
+}
+
+static int
+rndr_double_emphasis(struct buf *ob, const struct buf *text, void *opaque)
+{
+	BUFPUTSL(ob, "\\fB");
+	if (text) bufput(ob, text->data, text->size);
+	BUFPUTSL(ob, "\\fP");
+	return 1;
+}
+
+static int
+rndr_emphasis(struct buf *ob, const struct buf *text, void *opaque)
+{
+	BUFPUTSL(ob, "\\fI");
+	if (text) bufput(ob, text->data, text->size);
+	BUFPUTSL(ob, "\\fP");
+	return 1;
+}
+
+static int
+rndr_linebreak(struct buf *ob, void *opaque)
+{
+	BUFPUTSL(ob, "\n.LP\n");
+	return 1;
+}
+
+static void
+rndr_normal_text(struct buf *ob, const struct buf *text, void *opaque)
+{
+	if (text)
+		escape_roff(ob, text->data, text->size);
+}
+
+void
+sdman_renderer(struct sd_callbacks *callbacks)
+{
+	static const struct sd_callbacks cb_default = {
+		rndr_blockcode,
+		NULL,
+		NULL,
+		rndr_header,
+		NULL,
+		rndr_list,
+		rndr_listitem,
+		rndr_paragraph,
+		NULL,
+		NULL,
+		NULL,
+		NULL,
+		NULL,
+
+		NULL,
+		rndr_codespan,
+		rndr_double_emphasis,
+		rndr_emphasis,
+		NULL,
+		NULL,
+		NULL,
+		NULL,
+		rndr_linebreak,
+		NULL,
+		NULL,
+		NULL,
+		NULL,
+		NULL,
+		NULL,
+		NULL,
+
+		NULL,
+		rndr_normal_text,
+
+		NULL,
+		NULL,
+
+		NULL,
+		NULL,
+	};
+
+	memcpy(callbacks, &cb_default, sizeof(struct sd_callbacks));
+}
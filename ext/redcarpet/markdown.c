@@ -34,12 +34,42 @@
 #define BUFFER_BLOCK 0
 #define BUFFER_SPAN 1
 
+/* how many budget checks happen between two calls to its poll */
+#define BUDGET_POLL_EVERY 64
+
+/* the copy of the document is kept between renders up to this size */
+#define DOC_KEEP_SIZE (64 * 1024)
+
+/* and so are the emphasis and link tables, up to this many entries */
+#define TABLE_KEEP_SIZE (64 * 1024)
+
+/* a span with more emphasis chars or brackets than this is searched
+ * for closers of that char by scanning, rather than tables this large */
+#define EMPH_INDEX_MAX (1024 * 1024)
+
+/* and one with more brackets, parens or quotes for links */
+#define LINK_INDEX_MAX (1024 * 1024)
+
 #define MKD_LI_END 8	/* internal list flag */
 
+/* line classes, as tested by is_empty, is_hrule and friends */
+enum markdown_line_t {
+	LINE_EMPTY = (1 << 0),
+	LINE_HRULE = (1 << 1),
+	LINE_ATXHEADER = (1 << 2),
+	LINE_QUOTE = (1 << 3),
+	LINE_CODE = (1 << 4),
+	LINE_SETEXT = (1 << 5),
+	LINE_ULI = (1 << 6),
+	LINE_OLI = (1 << 7),
+	LINE_FENCE = (1 << 8)
+};
+
 #define gperf_case_strncmp(s1, s2, n) strncasecmp(s1, s2, n)
 #define GPERF_DOWNCASE 1
 #define GPERF_CASE_STRNCMP 1
 #include "html_blocks.h"
+#include "emoji.h"
 
 /***************
  * LOCAL TYPES *
@@ -49,12 +79,23 @@
 struct link_ref {
 	unsigned int id;
 
+	const uint8_t *name;
+	size_t name_size;
+
 	struct buf *link;
 	struct buf *title;
 
 	struct link_ref *next;
 };
 
+/* link_refs: chained hash of the link references in a document */
+struct link_refs {
+	struct link_ref **table;
+	size_t size;
+	size_t count;
+	size_t longest;		/* size of the longest name */
+};
+
 /* footnote_ref: reference to a footnote */
 struct footnote_ref {
 	unsigned int id;
@@ -62,20 +103,27 @@ struct footnote_ref {
 	int is_used;
 	unsigned int num;
 
-	struct buf *contents;
-};
+	const uint8_t *name;
+	size_t name_size;
 
-/* footnote_item: an item in a footnote_list */
-struct footnote_item {
-	struct footnote_ref *ref;
-	struct footnote_item *next;
+	struct buf *contents;
+	size_t src_offset;
 };
 
-/* footnote_list: linked list of footnote_item */
+/* footnote_list: footnote definitions, stored contiguously in
+ * document order, with an open-addressed index on their names.
+ * `used` holds the positions of the referenced ones, in the
+ * order they are first referenced */
 struct footnote_list {
 	unsigned int count;
-	struct footnote_item *head;
-	struct footnote_item *tail;
+	unsigned int asize;
+	struct footnote_ref *items;
+
+	unsigned int *index;
+	unsigned int index_size;
+
+	unsigned int used_count;
+	unsigned int *used;
 };
 
 /* char_trigger: function pointer to render active chars */
@@ -100,6 +148,9 @@ static size_t char_autolink_email(struct buf *ob, struct sd_markdown *rndr, uint
 static size_t char_autolink_www(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset, size_t size);
 static size_t char_link(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset, size_t size);
 static size_t char_superscript(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset, size_t size);
+static size_t char_emoji(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset, size_t size);
+static size_t char_mention(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset, size_t size);
+static size_t char_issue(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset, size_t size);
 
 enum markdown_char_t {
 	MD_CHAR_NONE = 0,
@@ -114,7 +165,10 @@ enum markdown_char_t {
 	MD_CHAR_AUTOLINK_EMAIL,
 	MD_CHAR_AUTOLINK_WWW,
 	MD_CHAR_SUPERSCRIPT,
-	MD_CHAR_QUOTE
+	MD_CHAR_QUOTE,
+	MD_CHAR_EMOJI,
+	MD_CHAR_MENTION,
+	MD_CHAR_ISSUE
 };
 
 static char_trigger markdown_char_ptrs[] = {
@@ -130,7 +184,120 @@ static char_trigger markdown_char_ptrs[] = {
 	&char_autolink_email,
 	&char_autolink_www,
 	&char_superscript,
-	&char_quote
+	&char_quote,
+	&char_emoji,
+	&char_mention,
+	&char_issue
+};
+
+/* emph_index: where closer searches for one emphasis char stop in a span */
+/*	there is an entry for every `c` of the span and every unescaped
+ *	'[', in order; the other chars never change where a search stops.
+ *	Entries refer to each other by index + 1, 0 meaning "none" */
+struct emph_index {
+	uint32_t *pos;		/* offset of the entry in the span */
+	uint32_t *scan;		/* the `c` a search starting at the entry stops at */
+	uint32_t *close[3];	/* the `c` a 1, 2 or 3 char emphasis closes at */
+	size_t count;
+	int built;
+	int unindexed;		/* too large or out of memory: scan instead */
+};
+
+/* bracket_index: the matching ']' of every '[' of a span */
+struct bracket_index {
+	uint32_t *pos;		/* offset of the '[' in the span */
+	uint32_t *close;	/* offset of its ']', 0 if there is none */
+	size_t count;
+	int built;
+	int unindexed;		/* too large or out of memory: scan instead */
+};
+
+/* tail_index: where the link destination and title scans of a span stop */
+/*	there is an entry for every paren and quote such a scan can stop
+ *	on, in order; a destination starting anywhere after one entry and
+ *	up to the next ends at the same place */
+struct tail_index {
+	uint32_t *pos;		/* offset of the entry in the span */
+	uint32_t *tail;		/* end of a destination starting up to the entry */
+	uint32_t *rpar;		/* next ')' at or after the entry */
+	uint32_t *squote;	/* next '\'' at or after the entry */
+	uint32_t *dquote;	/* next '"' at or after the entry */
+	size_t count;
+	int built;
+	int unindexed;		/* too large or out of memory: scan instead */
+};
+
+/* span_table_kind: what a span table is for, which the pools go by */
+enum span_table_kind {
+	TABLE_EMPH,		/* followed by one kind for every emphasis char */
+	TABLE_BRACKETS = TABLE_EMPH + 4,
+	TABLE_TAILS,
+	TABLE_KINDS
+};
+
+/* span_table: a span table in use, and the pool it goes back to */
+struct span_table {
+	uint32_t *data;
+	size_t count;
+	int kind;
+};
+
+/* inline_span: the span parse_inline is currently walking */
+struct inline_span {
+	uint8_t *data;
+	size_t size;
+
+	/* closer indexes for '*', '_', '~' and '=', built on first use */
+	struct emph_index emph[4];
+
+	/* bracket and link tail indexes, built on the second scan for them */
+	struct bracket_index brackets;
+	struct tail_index tails;
+	size_t link_closes;
+	size_t link_ends;
+
+	/* start of the run of normal text being written out */
+	size_t text_beg;
+
+	/* end of the last run of address chars looked at, and its last '@' */
+	size_t email_run_end;
+	size_t email_last_at;
+};
+
+/* line_info: one line of a block, and the classes it can have */
+struct line_info {
+	size_t beg;
+	uint8_t indent;
+
+	/* classes its first chars leave possible */
+	uint16_t maybe;
+};
+
+#define HTML_MISS_SLOTS 4
+
+/* html_miss: a block tag with no closer in the text from `from` on */
+struct html_miss {
+	const char *tag;
+	size_t from;
+};
+
+/* block_lines: the lines of the text parse_block is currently walking */
+struct block_lines {
+	uint8_t *data;
+	size_t size;
+
+	/* its lines are `count` entries of the line pool from `first`,
+	 * indexed up to the offset `end` */
+	size_t first;
+	size_t count;
+	size_t end;
+
+	/* last line looked up */
+	size_t cur;
+
+	/* HTML blocks found to be unclosed, replaced round-robin */
+	struct html_miss html_miss[HTML_MISS_SLOTS];
+	size_t html_miss_next;
 };
 
 /* render • structure containing one particular render */
@@ -138,20 +305,154 @@ struct sd_markdown {
 	struct sd_callbacks	cb;
 	void *opaque;
 
-	struct link_ref *refs[REF_TABLE_SIZE];
-	struct footnote_list footnotes_found;
-	struct footnote_list footnotes_used;
+	struct inline_span *span;
+
+	struct block_lines *lines;
+	struct line_info *line_pool;
+	size_t line_pool_size;
+	size_t line_pool_asize;
+
+	int *table_cols;
+	size_t table_cols_asize;
+
+	uint32_t *table_pool[TABLE_KINDS];
+	size_t table_pool_size[TABLE_KINDS];
+
+	/* span tables in use, innermost span last; a callback raising out
+	 * of the render leaves them here rather than on the C stack */
+	struct span_table *live_tables;
+	size_t live_size;
+	size_t live_asize;
+
+	struct buf *doc;
+	struct link_refs refs;
+	struct footnote_list footnotes;
 	uint8_t active_char[256];
 	struct stack work_bufs[2];
 	unsigned int ext_flags;
 	size_t max_nesting;
 	int in_link_body;
+
+	const struct sd_budget *budget;
+	struct buf *out;
+	size_t budget_checks;
+	size_t triggers;
+	size_t text_chars;
+	int text_space;
+	size_t blocks;
+	enum mkd_stop stopped;
+
+	void (*link_hook)(const struct sd_link *link, void *opaque);
+	void *link_hook_opaque;
+	void (*header_hook)(const struct sd_header *header, void *opaque);
+	void *header_hook_opaque;
+	const char *mention_url;
+	const char *issue_url;
+	const uint8_t *src;
+	size_t src_size;
+	size_t src_cursor;
+	size_t src_col_pos;
+	size_t src_col;
 };
 
 /***************************
  * HELPER FUNCTIONS *
  ***************************/
 
+/* budget_check • charges a step to the render budget, marking the render stopped once it runs out */
+/*	ob is the buffer the step writes to; unless it is the output itself,
+ *	the block it is part of has not been added to the output yet */
+static int
+budget_check(struct sd_markdown *rndr, struct buf *ob, int trigger)
+{
+	const struct sd_budget *budget = rndr->budget;
+	size_t out_size = rndr->out->size;
+
+	if (ob != rndr->out)
+		out_size += ob->size;
+
+	if (budget->max_output && out_size > budget->max_output)
+		rndr->stopped = MKD_STOP_OUTPUT;
+
+	else if (trigger && budget->max_triggers && ++rndr->triggers > budget->max_triggers)
+		rndr->stopped = MKD_STOP_TRIGGERS;
+
+	else if (budget->max_blocks && rndr->blocks >= budget->max_blocks)
+		rndr->stopped = MKD_STOP_BLOCKS;
+
+	else if (budget->max_text && rndr->text_chars >= budget->max_text)
+		rndr->stopped = MKD_STOP_TEXT;
+
+	else if (budget->poll && ++rndr->budget_checks % BUDGET_POLL_EVERY == 0 &&
+			budget->poll(budget->opaque))
+		rndr->stopped = MKD_STOP_POLL;
+
+	return rndr->stopped != MKD_STOP_NONE;
+}
+
+/* budget_spent • whether the render has to stop before taking another step */
+static inline int
+budget_spent(struct sd_markdown *rndr, struct buf *ob, int trigger)
+{
+	if (rndr->stopped)
+		return 1;
+
+	return rndr->budget ? budget_check(rndr, ob, trigger) : 0;
+}
+
+/* budget_text • how much of a run of text fits in what is left of max_text */
+/*	a run that doesn't fit stops the render; it is cut after its last
+ *	whole word, and only cut inside a word that starts the excerpt.
+ *	Entities and autolinks are counted too, but never cut */
+static size_t
+budget_text(struct sd_markdown *rndr, const uint8_t *data, size_t size)
+{
+	size_t i, left, chars = 0;
+
+	if (!rndr->budget || !rndr->budget->max_text || !size)
+		return size;
+
+	if (rndr->stopped == MKD_STOP_TEXT)
+		return 0;
+
+	left = rndr->budget->max_text - rndr->text_chars;
+
+	for (i = 0; i < size; ++i) {
+		if ((data[i] & 0xC0) == 0x80)
+			continue; /* UTF-8 continuation byte */
+		if (chars == left)
+			break;
+		chars++;
+	}
+
+	if (i == size) {
+		rndr->text_chars += chars;
+		rndr->text_space = (data[size - 1] == ' ' || data[size - 1] == '\n');
+		return size;
+	}
+
+	rndr->stopped = MKD_STOP_TEXT;
+
+	if (data[i] != ' ' && data[i] != '\n') {
+		size_t word = i;
+
+		while (word > 0 && data[word - 1] != ' ' && data[word - 1] != '\n')
+			word--;
+
+		if (word > 0 || (rndr->text_space && rndr->text_chars > 0))
+			i = word;
+	}
+
+	while (i > 0 && (data[i - 1] == ' ' || data[i - 1] == '\n'))
+		i--;
+
+	for (chars = 0; chars < i; ++chars)
+		if ((data[chars] & 0xC0) != 0x80)
+			rndr->text_chars++;
+
+	return i;
+}
+
 static inline struct buf *
 rndr_newbuf(struct sd_markdown *rndr, int type)
 {
@@ -209,33 +510,97 @@ hash_link_ref(const uint8_t *link_ref, size_t length)
 	return hash;
 }
 
+/* ref_name_eq • whether two reference names match, ignoring case */
+static int
+ref_name_eq(const uint8_t *a, size_t a_size, const uint8_t *b, size_t b_size)
+{
+	size_t i;
+
+	if (a_size != b_size)
+		return 0;
+
+	for (i = 0; i < a_size; ++i)
+		if (tolower(a[i]) != tolower(b[i]))
+			return 0;
+
+	return 1;
+}
+
+/* grow_link_refs • doubles the buckets of the table, keeping every chain newest first */
+static int
+grow_link_refs(struct link_refs *refs)
+{
+	size_t i, size = refs->size ? refs->size * 2 : REF_TABLE_SIZE;
+	struct link_ref **table = calloc(size, sizeof(struct link_ref *));
+
+	if (!table)
+		return 0;
+
+	for (i = 0; i < refs->size; ++i) {
+		struct link_ref *r = refs->table[i], *older = NULL, *next;
+
+		/* reverse the chain, then move it over oldest first */
+		while (r) {
+			next = r->next;
+			r->next = older;
+			older = r;
+			r = next;
+		}
+
+		for (r = older; r; r = next) {
+			next = r->next;
+			r->next = table[r->id & (size - 1)];
+			table[r->id & (size - 1)] = r;
+		}
+	}
+
+	free(refs->table);
+	refs->table = table;
+	refs->size = size;
+	return 1;
+}
+
 static struct link_ref *
 add_link_ref(
-	struct link_ref **references,
+	struct link_refs *refs,
 	const uint8_t *name, size_t name_size)
 {
-	struct link_ref *ref = calloc(1, sizeof(struct link_ref));
+	struct link_ref *ref;
+
+	if (refs->count >= refs->size && !grow_link_refs(refs) && !refs->size)
+		return NULL;
 
+	ref = calloc(1, sizeof(struct link_ref));
 	if (!ref)
 		return NULL;
 
 	ref->id = hash_link_ref(name, name_size);
-	ref->next = references[ref->id % REF_TABLE_SIZE];
+	ref->name = name;
+	ref->name_size = name_size;
+	ref->next = refs->table[ref->id & (refs->size - 1)];
+
+	if (name_size > refs->longest)
+		refs->longest = name_size;
 
-	references[ref->id % REF_TABLE_SIZE] = ref;
+	refs->table[ref->id & (refs->size - 1)] = ref;
+	refs->count++;
 	return ref;
 }
 
 static struct link_ref *
-find_link_ref(struct link_ref **references, uint8_t *name, size_t length)
+find_link_ref(struct link_refs *refs, uint8_t *name, size_t length)
 {
-	unsigned int hash = hash_link_ref(name, length);
+	unsigned int hash;
 	struct link_ref *ref = NULL;
 
-	ref = references[hash % REF_TABLE_SIZE];
+	if (!refs->count)
+		return NULL;
+
+	hash = hash_link_ref(name, length);
+	ref = refs->table[hash & (refs->size - 1)];
 
 	while (ref != NULL) {
-		if (ref->id == hash)
+		if (ref->id == hash && ref_name_eq(ref->name, ref->name_size, name, length))
 			return ref;
 
 		ref = ref->next;
@@ -245,12 +610,12 @@ find_link_ref(struct link_ref **references, uint8_t *name, size_t length)
 }
 
 static void
-free_link_refs(struct link_ref **references)
+free_link_refs(struct link_refs *refs)
 {
 	size_t i;
 
-	for (i = 0; i < REF_TABLE_SIZE; ++i) {
-		struct link_ref *r = references[i];
+	for (i = 0; refs->count && i < refs->size; ++i) {
+		struct link_ref *r = refs->table[i];
 		struct link_ref *next;
 
 		while (r) {
@@ -260,77 +625,154 @@ free_link_refs(struct link_ref **references)
 			free(r);
 			r = next;
 		}
+
+		refs->table[i] = NULL;
+	}
+
+	refs->count = 0;
+	refs->longest = 0;
+
+	/* a table grown for a document full of references isn't kept */
+	if (refs->size > REF_TABLE_SIZE * 8) {
+		free(refs->table);
+		refs->table = NULL;
+		refs->size = 0;
 	}
 }
 
-static struct footnote_ref *
-create_footnote_ref(struct footnote_list *list, const uint8_t *name, size_t name_size)
+/* footnote_slot • index slot holding `name`, or the empty one
+ * where it would go; the index is kept at most half full */
+static unsigned int *
+footnote_slot(struct footnote_list *list, unsigned int hash, const uint8_t *name, size_t length)
 {
-	struct footnote_ref *ref = calloc(1, sizeof(struct footnote_ref));
-	if (!ref)
-		return NULL;
+	unsigned int mask = list->index_size - 1;
+	unsigned int i = hash & mask;
 
-	ref->id = hash_link_ref(name, name_size);
+	while (list->index[i] != 0) {
+		struct footnote_ref *ref = &list->items[list->index[i] - 1];
 
-	return ref;
+		if (ref->id == hash && ref_name_eq(ref->name, ref->name_size, name, length))
+			break;
+
+		i = (i + 1) & mask;
+	}
+
+	return &list->index[i];
 }
 
 static int
-add_footnote_ref(struct footnote_list *list, struct footnote_ref *ref)
+grow_footnote_list(struct footnote_list *list)
 {
-	struct footnote_item *item = calloc(1, sizeof(struct footnote_item));
-	if (!item)
+	unsigned int neoasz = list->asize ? list->asize * 2 : 16;
+	struct footnote_ref *neoitems;
+	unsigned int *neoused, *neoindex;
+	unsigned int i;
+
+	neoitems = realloc(list->items, neoasz * sizeof(struct footnote_ref));
+	if (!neoitems)
 		return 0;
-	item->ref = ref;
+	list->items = neoitems;
 
-	if (list->head == NULL) {
-		list->head = list->tail = item;
-	} else {
-		list->tail->next = item;
-		list->tail = item;
+	neoused = realloc(list->used, neoasz * sizeof(unsigned int));
+	if (!neoused)
+		return 0;
+	list->used = neoused;
+
+	neoindex = calloc(neoasz * 2, sizeof(unsigned int));
+	if (!neoindex)
+		return 0;
+
+	free(list->index);
+	list->index = neoindex;
+	list->index_size = neoasz * 2;
+	list->asize = neoasz;
+
+	/* rehash, keeping the first definition of every name */
+	for (i = 0; i < list->count; ++i) {
+		struct footnote_ref *ref = &list->items[i];
+		unsigned int *slot = footnote_slot(list, ref->id, ref->name, ref->name_size);
+
+		if (*slot == 0)
+			*slot = i + 1;
 	}
-	list->count++;
 
 	return 1;
 }
 
+/* add_footnote_ref • store a definition; `name` must outlive the
+ * render. A later definition of the same name is kept (its contents
+ * are released with the others) but never found */
 static struct footnote_ref *
-find_footnote_ref(struct footnote_list *list, uint8_t *name, size_t length)
+add_footnote_ref(struct footnote_list *list, const uint8_t *name, size_t name_size)
 {
-	unsigned int hash = hash_link_ref(name, length);
-	struct footnote_item *item = NULL;
+	struct footnote_ref *ref;
+	unsigned int *slot;
 
-	item = list->head;
+	if (list->count >= list->asize && !grow_footnote_list(list))
+		return NULL;
 
-	while (item != NULL) {
-		if (item->ref->id == hash)
-			return item->ref;
-		item = item->next;
-	}
+	ref = &list->items[list->count];
+	memset(ref, 0x0, sizeof(struct footnote_ref));
+	ref->id = hash_link_ref(name, name_size);
+	ref->name = name;
+	ref->name_size = name_size;
 
-	return NULL;
+	slot = footnote_slot(list, ref->id, name, name_size);
+	if (*slot == 0)
+		*slot = list->count + 1;
+
+	list->count++;
+	return ref;
+}
+
+static struct footnote_ref *
+find_footnote_ref(struct footnote_list *list, uint8_t *name, size_t length)
+{
+	unsigned int *slot;
+
+	if (list->count == 0)
+		return NULL;
+
+	slot = footnote_slot(list, hash_link_ref(name, length), name, length);
+	return *slot ? &list->items[*slot - 1] : NULL;
 }
 
+/* use_footnote_ref • number a footnote on its first reference */
 static void
-free_footnote_ref(struct footnote_ref *ref)
+use_footnote_ref(struct footnote_list *list, struct footnote_ref *ref)
 {
-	bufrelease(ref->contents);
-	free(ref);
+	if (ref->is_used)
+		return;
+
+	list->used[list->used_count++] = (unsigned int)(ref - list->items);
+	ref->is_used = 1;
+	ref->num = list->used_count;
 }
 
+/* reset_footnote_list • release the definitions of the last
+ * render, keeping the storage around for the next one */
 static void
-free_footnote_list(struct footnote_list *list, int free_refs)
+reset_footnote_list(struct footnote_list *list)
 {
-	struct footnote_item *item = list->head;
-	struct footnote_item *next;
+	unsigned int i;
 
-	while (item) {
-		next = item->next;
-		if (free_refs)
-			free_footnote_ref(item->ref);
-		free(item);
-		item = next;
-	}
+	for (i = 0; i < list->count; ++i)
+		bufrelease(list->items[i].contents);
+
+	if (list->count)
+		memset(list->index, 0x0, list->index_size * sizeof(unsigned int));
+
+	list->count = 0;
+	list->used_count = 0;
+}
+
+static void
+free_footnote_list(struct footnote_list *list)
+{
+	reset_footnote_list(list);
+	free(list->items);
+	free(list->used);
+	free(list->index);
 }
 
 /*
@@ -457,18 +899,99 @@ tag_length(uint8_t *data, size_t size, enum mkd_autolink *autolink)
 	return i + 1;
 }
 
+/* get_span_table • room for `count` entries of a span table */
+/*	the tables of a long span can run to megabytes; reusing those of an
+ *	earlier span spares fresh pages from the system every time. The
+ *	table is kept on the list of live ones until its span is done. */
+static uint32_t *
+get_span_table(struct sd_markdown *rndr, int kind, size_t count)
+{
+	struct span_table *live;
+	uint32_t *table;
+
+	if (rndr->live_size == rndr->live_asize) {
+		size_t asize = rndr->live_asize ? rndr->live_asize * 2 : 16;
+
+		live = realloc(rndr->live_tables, asize * sizeof(struct span_table));
+		if (!live)
+			return NULL;
+
+		rndr->live_tables = live;
+		rndr->live_asize = asize;
+	}
+
+	table = rndr->table_pool[kind];
+	if (table && rndr->table_pool_size[kind] >= count)
+		rndr->table_pool[kind] = NULL;
+	else if (!(table = malloc(count * sizeof(uint32_t))))
+		return NULL;
+
+	live = &rndr->live_tables[rndr->live_size++];
+	live->data = table;
+	live->count = count;
+	live->kind = kind;
+	return table;
+}
+
+/* release_span_tables • takes back the live tables past `base`, keeping the largest ones */
+static void
+release_span_tables(struct sd_markdown *rndr, size_t base)
+{
+	struct span_table *live;
+
+	while (rndr->live_size > base) {
+		live = &rndr->live_tables[--rndr->live_size];
+
+		if (rndr->table_pool[live->kind] &&
+			rndr->table_pool_size[live->kind] >= live->count) {
+			free(live->data);
+			continue;
+		}
+
+		free(rndr->table_pool[live->kind]);
+		rndr->table_pool[live->kind] = live->data;
+		rndr->table_pool_size[live->kind] = live->count;
+	}
+}
+
+/* first_entry • index of the first of `count` ascending offsets that is at least `offset` */
+static size_t
+first_entry(const uint32_t *pos, size_t count, size_t offset)
+{
+	size_t lo = 0, hi = count, mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (pos[mid] < offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
 /* parse_inline • parses inline markdown elements */
 static void
 parse_inline(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t size)
 {
-	size_t i = 0, end = 0;
+	size_t i = 0, end = 0, written, text_chars, live_base;
 	uint8_t action = 0;
 	struct buf work = { 0, 0, 0, 0 };
+	struct inline_span span, *parent_span;
 
 	if (rndr->work_bufs[BUFFER_SPAN].size +
 		rndr->work_bufs[BUFFER_BLOCK].size > rndr->max_nesting)
 		return;
 
+	memset(&span, 0x0, sizeof(span));
+	span.data = data;
+	span.size = size;
+
+	parent_span = rndr->span;
+	rndr->span = &span;
+	live_base = rndr->live_size;
+
 	while (i < size) {
 		/* copying inactive chars into the output */
 		while (end < size && (action = rndr->active_char[data[end]]) == 0) {
@@ -477,28 +1000,198 @@ parse_inline(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t siz
 
 		if (rndr->cb.normal_text) {
 			work.data = data + i;
-			work.size = end - i;
+			work.size = budget_text(rndr, data + i, end - i);
 			rndr->cb.normal_text(ob, &work, rndr->opaque);
 		}
 		else
-			bufput(ob, data + i, end - i);
+			bufput(ob, data + i, budget_text(rndr, data + i, end - i));
 
 		if (end >= size) break;
 		i = end;
 
+		if (budget_spent(rndr, ob, 1))
+			break;
+
+		written = ob->size;
+		text_chars = rndr->text_chars;
+
 		end = markdown_char_ptrs[(int)action](ob, rndr, data + i, i, size - i);
+
+		/* a span max_text has cut down to nothing is taken back,
+		 * along with the space leading up to it */
+		if (rndr->stopped == MKD_STOP_TEXT && rndr->text_chars == text_chars) {
+			ob->size = written;
+			while (ob->size && (ob->data[ob->size - 1] == ' ' || ob->data[ob->size - 1] == '\n'))
+				ob->size--;
+			break;
+		}
+
 		if (!end) /* no action from the callback */
 			end = i + 1;
 		else {
 			i += end;
 			end = i;
+
+			/* escaped chars are written out as text */
+			if (action != MD_CHAR_ESCAPE)
+				span.text_beg = i;
+		}
+	}
+
+	rndr->span = parent_span;
+	release_span_tables(rndr, live_base);
+}
+
+/* build_emph_index • resolves the emphasis closers of a span in one pass */
+/*	a closer search starting at i stops at the next unescaped `c`,
+ *	skipping over links, or at the first `c` inside a link that is never
+ *	closed; close1..3 then follow the chain of such stops to the first
+ *	one that can end a 1, 2 or 3 char emphasis. Walking backwards, every
+ *	entry depends only on entries already filled in, and the state of
+ *	the chars in between fits in a few variables, so the index costs
+ *	O(size) time and O(entries) room no matter how many openers fail. */
+static void
+build_emph_index(struct sd_markdown *rndr, struct emph_index *idx,
+	uint8_t *data, size_t size, uint8_t c, int t)
+{
+	uint32_t *tables;
+	size_t i, j, count = 0, chars = 0;
+	size_t next_c_pos = 0, next_sq = 0, next_par = 0, next_text = 0;
+	uint32_t s1 = 0, s2 = 0, si, next_c = 0;
+	uint32_t link_skip = 0, after_sq = 0, after_par = 0, at_text = 0;
+	int link_skip_final = 0;
+
+	idx->built = 1;
+
+	for (i = 0; i < size; ++i) {
+		if (data[i] == c)
+			chars++;
+		else if (data[i] != '[' || (i > 0 && data[i - 1] == '\\'))
+			continue;
+		count++;
+	}
+
+	/* the opener is the only `c`, so nothing can close it */
+	if (chars < 2)
+		return;
+
+	tables = NULL;
+	if (count <= EMPH_INDEX_MAX && size < UINT32_MAX)
+		tables = get_span_table(rndr, TABLE_EMPH + t, 5 * count);
+
+	if (!tables) {
+		idx->unindexed = 1;
+		return;
+	}
+
+	idx->pos = tables;
+	idx->scan = idx->pos + count;
+	idx->close[0] = idx->scan + count;
+	idx->close[1] = idx->close[0] + count;
+	idx->close[2] = idx->close[1] + count;
+	idx->count = count;
+
+	/* s1 and s2 are where searches starting at i + 1 and i + 2 stop */
+	for (i = size, j = count; i-- > 0; ) {
+		int escaped = (i > 0 && data[i - 1] == '\\');
+		int entry = (data[i] == c || (data[i] == '[' && !escaped));
+
+		if (entry)
+			idx->pos[--j] = (uint32_t)i;
+
+		if (data[i] == c && !escaped)
+			si = (uint32_t)(j + 1);
+
+		else if (data[i] == '[' && !escaped) {
+			/* a link is skipped whole; if it is broken, the first
+			 * `c` found inside of it is taken instead */
+			uint32_t inner_c = (next_c && (!next_sq || next_c_pos < next_sq)) ? next_c : 0;
+
+			if (!next_sq)
+				si = inner_c;
+			else if (link_skip_final || !inner_c)
+				si = link_skip;
+			else
+				si = inner_c;
+		}
+
+		else
+			si = s1;
+
+		if (entry) {
+			idx->scan[j] = si;
+			idx->close[0][j] = idx->close[1][j] = idx->close[2][j] = 0;
+		}
+
+		/* position 0 can never close an emphasis */
+		if (data[i] == c && i > 0) {
+			int after_space = _isspace(data[i - 1]);
+
+			if (!after_space &&
+				!((rndr->ext_flags & MKDEXT_NO_INTRA_EMPHASIS) &&
+				i + 1 < size && _isalnum(data[i + 1])))
+				idx->close[0][j] = (uint32_t)(j + 1);
+			else if (s1)
+				idx->close[0][j] = idx->close[0][s1 - 1];
+
+			if (!after_space && i + 1 < size && data[i + 1] == c)
+				idx->close[1][j] = (uint32_t)(j + 1);
+			else if (s2)
+				idx->close[1][j] = idx->close[1][s2 - 1];
+
+			if (!after_space)
+				idx->close[2][j] = (uint32_t)(j + 1);
+			else if (s1)
+				idx->close[2][j] = idx->close[2][s1 - 1];
+		}
+
+		/* where a search resumes after a link whose text ends here */
+		if (data[i] == ']') {
+			size_t w = next_text;
+			link_skip_final = 0;
+
+			if (!w)
+				link_skip = 0;
+			else if (data[w] == '(' || data[w] == '[') {
+				size_t tail_end = (data[w] == '(') ? next_par : next_sq;
+
+				if (tail_end) {
+					link_skip = (data[w] == '(') ? after_par : after_sq;
+					link_skip_final = 1;
+				} else
+					link_skip = next_c;
+			}
+			else
+				link_skip = at_text;
+
+			next_sq = i;
+			after_sq = s1;
+		}
+
+		if (data[i] == ')') {
+			next_par = i;
+			after_par = s1;
+		}
+
+		if (data[i] == c) {
+			next_c = (uint32_t)(j + 1);
+			next_c_pos = i;
+		}
+
+		if (!_isspace(data[i])) {
+			next_text = i;
+			at_text = si;
 		}
+
+		s2 = s1;
+		s1 = si;
 	}
 }
 
-/* find_emph_char • looks for the next emph uint8_t, skipping other constructs */
+/* scan_emph_char • looks for the next `c` after data[0], skipping over links */
+/*	the search the index is built from, for spans too large to index */
 static size_t
-find_emph_char(uint8_t *data, size_t size, uint8_t c)
+scan_emph_char(uint8_t *data, size_t size, uint8_t c)
 {
 	size_t i = 1;
 
@@ -510,42 +1203,20 @@ find_emph_char(uint8_t *data, size_t size, uint8_t c)
 			return 0;
 
 		/* not counting escaped chars */
-		if (i && data[i - 1] == '\\') {
+		if (data[i - 1] == '\\') {
 			i++; continue;
 		}
 
 		if (data[i] == c)
 			return i;
 
-		if (data[i] == '`') {
-			size_t span_nb = 0, bt;
+		/* skipping a link */
+		else {
 			size_t tmp_i = 0;
+			uint8_t cc;
 
-			/* counting the number of opening backticks */
-			while (i < size && data[i] == '`') {
-				i++; span_nb++;
-			}
-
-			if (i >= size) return 0;
-
-			/* finding the matching closing sequence */
-			bt = 0;
-			while (i < size && bt < span_nb) {
-				if (!tmp_i && data[i] == c) tmp_i = i;
-				if (data[i] == '`') bt++;
-				else bt = 0;
-				i++;
-			}
-
-			if (i >= size) return tmp_i;
-		}
-		/* skipping a link */
-		else if (data[i] == '[') {
-			size_t tmp_i = 0;
-			uint8_t cc;
-
-			i++;
-			while (i < size && data[i] != ']') {
+			i++;
+			while (i < size && data[i] != ']') {
 				if (!tmp_i && data[i] == c) tmp_i = i;
 				i++;
 			}
@@ -587,77 +1258,142 @@ find_emph_char(uint8_t *data, size_t size, uint8_t c)
 	return 0;
 }
 
+/* scan_emph_closer • follows scan_emph_char to a closer of the given width */
+/*	`i` is the offset in the span the search starts after */
+static size_t
+scan_emph_closer(struct sd_markdown *rndr, size_t i, uint8_t c, int width)
+{
+	uint8_t *data = rndr->span->data;
+	size_t size = rndr->span->size, len;
+
+	while ((len = scan_emph_char(data + i, size - i, c)) != 0) {
+		i += len;
+
+		if (_isspace(data[i - 1])) {
+			if (width == 2) i++;
+			continue;
+		}
+
+		if (width == 1 && (rndr->ext_flags & MKDEXT_NO_INTRA_EMPHASIS) &&
+			i + 1 < size && _isalnum(data[i + 1]))
+			continue;
+
+		if (width == 2 && (i + 1 >= size || data[i + 1] != c)) {
+			i++;
+			continue;
+		}
+
+		return i;
+	}
+
+	return 0;
+}
+
+/* find_emph_char • looks for the closer of a 1, 2 or 3 char emphasis */
+/*	the search starts right after data[from]; returns the offset of the
+ *	closer from data, or 0 if there is none */
+static size_t
+find_emph_char(struct sd_markdown *rndr, uint8_t *data, size_t from, uint8_t c, int width)
+{
+	struct inline_span *span = rndr->span;
+	struct emph_index *idx;
+	size_t pos, j;
+	uint32_t stop, closer;
+	int t;
+
+	switch (c) {
+	case '*': t = 0; break;
+	case '_': t = 1; break;
+	case '~': t = 2; break;
+	default: t = 3; break;
+	}
+
+	idx = &span->emph[t];
+	if (!idx->built)
+		build_emph_index(rndr, idx, span->data, span->size, c, t);
+
+	pos = (size_t)(data - span->data);
+	if (idx->unindexed) {
+		j = scan_emph_closer(rndr, pos + from, c, width);
+		return j ? j - pos : 0;
+	}
+
+	if (!idx->count)
+		return 0;
+
+	/* the chars before the first entry at or after the start don't
+	 * change where the search stops */
+	j = first_entry(idx->pos, idx->count, pos + from + 1);
+
+	if (j == idx->count || !(stop = idx->scan[j]))
+		return 0;
+
+	closer = idx->close[width - 1][stop - 1];
+	return closer ? idx->pos[closer - 1] - pos : 0;
+}
+
 /* parse_emph1 • parsing single emphase */
 /* closed by a symbol not preceded by whitespace and not followed by symbol */
 static size_t
 parse_emph1(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t size, uint8_t c)
 {
-	size_t i = 0, len;
+	size_t i = 0;
 	struct buf *work = 0;
+	int (*render_method)(struct buf *ob, const struct buf *text, void *opaque);
 	int r;
 
-	/* skipping one symbol if coming from emph3 */
-	if (size > 1 && data[0] == c && data[1] == c) i = 1;
-
-	while (i < size) {
-		len = find_emph_char(data + i, size - i, c);
-		if (!len) return 0;
-		i += len;
-		if (i >= size) return 0;
+	if (rndr->ext_flags & MKDEXT_UNDERLINE && c == '_')
+		render_method = rndr->cb.underline;
+	else
+		render_method = rndr->cb.emphasis;
 
-		if (data[i] == c && !_isspace(data[i - 1])) {
+	if (!render_method)
+		return 0;
 
-			if (rndr->ext_flags & MKDEXT_NO_INTRA_EMPHASIS) {
-				if (i + i < size && _isalnum(data[i + 1]))
-					continue;
-			}
+	/* skipping one symbol if coming from emph3 */
+	if (size > 1 && data[0] == c && data[1] == c) i = 1;
 
-			work = rndr_newbuf(rndr, BUFFER_SPAN);
-			parse_inline(work, rndr, data, i);
+	i = find_emph_char(rndr, data, i, c, 1);
+	if (!i) return 0;
 
-			if (rndr->ext_flags & MKDEXT_UNDERLINE && c == '_')
-				r = rndr->cb.underline(ob, work, rndr->opaque);
-			else
-				r = rndr->cb.emphasis(ob, work, rndr->opaque);
+	work = rndr_newbuf(rndr, BUFFER_SPAN);
+	parse_inline(work, rndr, data, i);
 
-			rndr_popbuf(rndr, BUFFER_SPAN);
-			return r ? i + 1 : 0;
-		}
-	}
+	r = render_method(ob, work, rndr->opaque);
 
-	return 0;
+	rndr_popbuf(rndr, BUFFER_SPAN);
+	return r ? i + 1 : 0;
 }
 
 /* parse_emph2 • parsing single emphase */
 static size_t
 parse_emph2(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t size, uint8_t c)
 {
-	size_t i = 0, len;
+	size_t i;
 	struct buf *work = 0;
+	int (*render_method)(struct buf *ob, const struct buf *text, void *opaque);
 	int r;
 
-	while (i < size) {
-		len = find_emph_char(data + i, size - i, c);
-		if (!len) return 0;
-		i += len;
+	if (c == '~')
+		render_method = rndr->cb.strikethrough;
+	else if (c == '=')
+		render_method = rndr->cb.highlight;
+	else
+		render_method = rndr->cb.double_emphasis;
 
-		if (i + 1 < size && data[i] == c && data[i + 1] == c && i && !_isspace(data[i - 1])) {
-			work = rndr_newbuf(rndr, BUFFER_SPAN);
-			parse_inline(work, rndr, data, i);
+	if (!render_method)
+		return 0;
 
-			if (c == '~')
-				r = rndr->cb.strikethrough(ob, work, rndr->opaque);
-			else if (c == '=')
-				r = rndr->cb.highlight(ob, work, rndr->opaque);
-			else
-				r = rndr->cb.double_emphasis(ob, work, rndr->opaque);
+	i = find_emph_char(rndr, data, 0, c, 2);
+	if (!i) return 0;
 
-			rndr_popbuf(rndr, BUFFER_SPAN);
-			return r ? i + 2 : 0;
-		}
-		i++;
-	}
-	return 0;
+	work = rndr_newbuf(rndr, BUFFER_SPAN);
+	parse_inline(work, rndr, data, i);
+
+	r = render_method(ob, work, rndr->opaque);
+
+	rndr_popbuf(rndr, BUFFER_SPAN);
+	return r ? i + 2 : 0;
 }
 
 /* parse_emph3 • parsing single emphase */
@@ -665,41 +1401,33 @@ parse_emph2(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t size
 static size_t
 parse_emph3(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t size, uint8_t c)
 {
-	size_t i = 0, len;
+	size_t i, len;
 	int r;
 
-	while (i < size) {
-		len = find_emph_char(data + i, size - i, c);
-		if (!len) return 0;
-		i += len;
+	i = find_emph_char(rndr, data, 0, c, 3);
+	if (!i) return 0;
 
-		/* skip whitespace preceded symbols */
-		if (data[i] != c || _isspace(data[i - 1]))
-			continue;
-
-		if (i + 2 < size && data[i + 1] == c && data[i + 2] == c && rndr->cb.triple_emphasis) {
-			/* triple symbol found */
-			struct buf *work = rndr_newbuf(rndr, BUFFER_SPAN);
+	if (i + 2 < size && data[i + 1] == c && data[i + 2] == c && rndr->cb.triple_emphasis) {
+		/* triple symbol found */
+		struct buf *work = rndr_newbuf(rndr, BUFFER_SPAN);
 
-			parse_inline(work, rndr, data, i);
-			r = rndr->cb.triple_emphasis(ob, work, rndr->opaque);
-			rndr_popbuf(rndr, BUFFER_SPAN);
-			return r ? i + 3 : 0;
+		parse_inline(work, rndr, data, i);
+		r = rndr->cb.triple_emphasis(ob, work, rndr->opaque);
+		rndr_popbuf(rndr, BUFFER_SPAN);
+		return r ? i + 3 : 0;
 
-		} else if (i + 1 < size && data[i + 1] == c) {
-			/* double symbol found, handing over to emph1 */
-			len = parse_emph1(ob, rndr, data - 2, size + 2, c);
-			if (!len) return 0;
-			else return len - 2;
+	} else if (i + 1 < size && data[i + 1] == c) {
+		/* double symbol found, handing over to emph1 */
+		len = parse_emph1(ob, rndr, data - 2, size + 2, c);
+		if (!len) return 0;
+		else return len - 2;
 
-		} else {
-			/* single symbol found, handing over to emph2 */
-			len = parse_emph2(ob, rndr, data - 1, size + 1, c);
-			if (!len) return 0;
-			else return len - 1;
-		}
+	} else {
+		/* single symbol found, handing over to emph2 */
+		len = parse_emph2(ob, rndr, data - 1, size + 1, c);
+		if (!len) return 0;
+		else return len - 1;
 	}
-	return 0;
 }
 
 /* char_emphasis • single and double emphasis parsing */
@@ -788,6 +1516,11 @@ char_codespan(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t of
 	/* real code span */
 	if (f_begin < f_end) {
 		struct buf work = { data + f_begin, f_end - f_begin, 0, 0 };
+
+		work.size = budget_text(rndr, work.data, work.size);
+		if (!work.size)
+			return end;
+
 		if (!rndr->cb.codespan(ob, &work, rndr->opaque))
 			end = 0;
 	} else {
@@ -849,9 +1582,14 @@ char_escape(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offs
 	struct buf work = { 0, 0, 0, 0 };
 
 	if (size > 1) {
-		if (strchr(escape_chars, data[1]) == NULL)
+		/* with mentions on, an escaped '@' doesn't start one */
+		if (strchr(escape_chars, data[1]) == NULL &&
+			(data[1] != '@' || rndr->active_char['@'] != MD_CHAR_MENTION))
 			return 0;
 
+		if (!budget_text(rndr, data + 1, 1))
+			return 2;
+
 		if (rndr->cb.normal_text) {
 			work.data = data + 1;
 			work.size = 1;
@@ -884,6 +1622,8 @@ char_entity(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offs
 	else
 		return 0; /* lone '&' */
 
+	budget_text(rndr, data, 1);
+
 	if (rndr->cb.entity) {
 		work.data = data;
 		work.size = end;
@@ -894,6 +1634,157 @@ char_entity(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offs
 	return end;
 }
 
+/* source_column • column of src[i] once the tabs before it are expanded */
+/*	searches move forward through the document, so the column is walked
+ *	on from the last one asked for unless i is behind it */
+static size_t
+source_column(struct sd_markdown *rndr, size_t i)
+{
+	const uint8_t *src = rndr->src;
+	size_t pos = rndr->src_col_pos, col = rndr->src_col;
+
+	if (pos > i) {
+		pos = i;
+		col = 0;
+		while (pos > 0 && src[pos - 1] != '\n' && src[pos - 1] != '\r')
+			pos--;
+	}
+
+	for (; pos < i; pos++) {
+		if (src[pos] == '\n' || src[pos] == '\r')
+			col = 0;
+		else
+			col = (src[pos] == '\t') ? (col + 4) & ~(size_t)3 : col + 1;
+	}
+
+	rndr->src_col_pos = pos;
+	rndr->src_col = col;
+	return col;
+}
+
+/* source_matches • whether raw was copied from the document at src[i] */
+/*	the first pass expanded the tabs of the copy into spaces */
+static int
+source_matches(struct sd_markdown *rndr, size_t i, const uint8_t *raw, size_t size)
+{
+	const uint8_t *src = rndr->src;
+	size_t j = 0, col = 0, width;
+	int col_known = 0;
+
+	while (j < size) {
+		if (i >= rndr->src_size)
+			return 0;
+
+		if (src[i] == raw[j]) {
+			i++; j++; col++;
+			continue;
+		}
+
+		if (src[i] != '\t' || raw[j] != ' ')
+			return 0;
+
+		if (!col_known) {
+			col = source_column(rndr, i);
+			col_known = 1;
+		}
+
+		for (width = 4 - (col & 3); width > 0 && j < size; width--, j++, col++) {
+			if (raw[j] != ' ')
+				return 0;
+		}
+		i++;
+	}
+
+	return 1;
+}
+
+/* find_source • offset of a span of the working copy in the document */
+/*	only the first line is looked for, as the lines after it may have
+ *	lost a prefix on the way to the copy. Links turn up in the order
+ *	they are written in, save the footnotes which move the cursor back
+ *	to their definition, so the search goes on from the last one found */
+static size_t
+find_source(struct sd_markdown *rndr, const uint8_t *raw, size_t size)
+{
+	const uint8_t *p, *eol;
+	size_t i = rndr->src_cursor;
+
+	if ((eol = memchr(raw, '\n', size)) != NULL)
+		size = eol - raw;
+
+	/* leading blanks may have been a tab: the span is found from its
+	 * first char past them */
+	while (size && raw[0] == ' ') {
+		raw++;
+		size--;
+	}
+
+	if (!size)
+		return SD_NO_OFFSET;
+
+	while (i < rndr->src_size) {
+		p = memchr(rndr->src + i, raw[0], rndr->src_size - i);
+		if (!p)
+			break;
+
+		i = p - rndr->src;
+		if (source_matches(rndr, i, raw, size)) {
+			rndr->src_cursor = i + 1;
+			return i;
+		}
+		i++;
+	}
+
+	return SD_NO_OFFSET;
+}
+
+/* report_link • hands a link written as `raw` to the link hook */
+static void
+report_link(struct sd_markdown *rndr, enum mkd_link_kind kind,
+	const struct buf *url, const struct buf *title, const uint8_t *raw, size_t raw_size)
+{
+	struct sd_link link;
+
+	link.kind = kind;
+	link.url = url;
+	link.title = title;
+	link.offset = find_source(rndr, raw, raw_size);
+
+	rndr->link_hook(&link, rndr->link_hook_opaque);
+}
+
+/* report_autolink • report_link for autolinks, which renderers give a type */
+static void
+report_autolink(struct sd_markdown *rndr, const struct buf *link,
+	enum mkd_autolink type, const uint8_t *raw, size_t raw_size)
+{
+	struct buf *url;
+
+	if (type != MKDA_EMAIL) {
+		report_link(rndr, MKD_LINK_AUTOLINK, link, NULL, raw, raw_size);
+		return;
+	}
+
+	url = rndr_newbuf(rndr, BUFFER_SPAN);
+	BUFPUTSL(url, "mailto:");
+	bufput(url, link->data, link->size);
+	report_link(rndr, MKD_LINK_AUTOLINK, url, NULL, raw, raw_size);
+	rndr_popbuf(rndr, BUFFER_SPAN);
+}
+
+/* report_header • hands a header to the header hook */
+static void
+report_header(struct sd_markdown *rndr, const struct buf *text, size_t level, size_t offset)
+{
+	struct sd_header header;
+
+	header.level = (int)level;
+	header.text = text;
+	header.offset = offset;
+
+	rndr->header_hook(&header, rndr->header_hook_opaque);
+}
+
 /* char_langle_tag • '<' when tags or autolinks are allowed */
 static size_t
 char_langle_tag(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset, size_t size)
@@ -909,6 +1800,8 @@ char_langle_tag(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t
 			work.data = data + 1;
 			work.size = end - 2;
 			unscape_text(u_link, &work);
+			if (rndr->link_hook)
+				report_autolink(rndr, u_link, altype, data, end);
 			ret = rndr->cb.autolink(ob, u_link, altype, rndr->opaque);
 			rndr_popbuf(rndr, BUFFER_SPAN);
 		}
@@ -920,6 +1813,16 @@ char_langle_tag(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t
 	else return end;
 }
 
+/* autolink_max_rewind • how much of the text before an autolink can
+ * be taken back from the output: only what was written by the current
+ * run of normal text, and never more than the output holds */
+static size_t
+autolink_max_rewind(struct buf *ob, struct sd_markdown *rndr, size_t offset)
+{
+	size_t max_rewind = offset - rndr->span->text_beg;
+	return max_rewind < ob->size ? max_rewind : ob->size;
+}
+
 static size_t
 char_autolink_www(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset, size_t size)
 {
@@ -929,6 +1832,10 @@ char_autolink_www(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_
 	if (!rndr->cb.link || rndr->in_link_body)
 		return 0;
 
+	/* most 'w' don't start "www." */
+	if (size < 4 || data[1] != 'w' || data[2] != 'w' || data[3] != '.')
+		return 0;
+
 	link = rndr_newbuf(rndr, BUFFER_SPAN);
 
 	if ((link_len = sd_autolink__www(&rewind, link, data, offset, size, 0)) > 0) {
@@ -937,6 +1844,11 @@ char_autolink_www(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_
 		bufput(link_url, link->data, link->size);
 
 		ob->size -= rewind;
+		budget_text(rndr, link->data, link->size);
+
+		if (rndr->link_hook)
+			report_link(rndr, MKD_LINK_AUTOLINK, link_url, NULL, data - rewind, rewind + link_len);
+
 		if (rndr->cb.normal_text) {
 			link_text = rndr_newbuf(rndr, BUFFER_SPAN);
 			rndr->cb.normal_text(link_text, link, rndr->opaque);
@@ -952,19 +1864,56 @@ char_autolink_www(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_
 	return link_len;
 }
 
+/* email_is_last_at • whether no other '@' follows this one in its run of address chars */
+/*	an address holds a single '@', so all but the last of a run like
+ *	"a@a@a@" fail; the run is walked once for all of them instead of
+ *	once for every '@' */
+static int
+email_is_last_at(struct sd_markdown *rndr, uint8_t *data, size_t offset, size_t size)
+{
+	struct inline_span *span = rndr->span;
+	size_t i;
+
+	if (offset >= span->email_run_end) {
+		span->email_last_at = offset;
+
+		for (i = 1; i < size; ++i) {
+			if (data[i] == '@')
+				span->email_last_at = offset + i;
+			else if (!isalnum(data[i]) && strchr(".-_", data[i]) == NULL)
+				break;
+		}
+
+		span->email_run_end = offset + i;
+	}
+
+	return offset == span->email_last_at;
+}
+
 static size_t
 char_autolink_email(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset, size_t size)
 {
 	struct buf *link;
-	size_t link_len, rewind;
+	size_t link_len, rewind, max_rewind;
 
 	if (!rndr->cb.autolink || rndr->in_link_body)
 		return 0;
 
+	/* the address needs a local part right before the '@' */
+	max_rewind = autolink_max_rewind(ob, rndr, offset);
+	if (max_rewind == 0 || (!isalnum(data[-1]) && strchr(".+-_", data[-1]) == NULL))
+		return 0;
+
+	if (!email_is_last_at(rndr, data, offset, size))
+		return 0;
+
 	link = rndr_newbuf(rndr, BUFFER_SPAN);
 
-	if ((link_len = sd_autolink__email(&rewind, link, data, offset, size, 0)) > 0) {
+	if ((link_len = sd_autolink__email(&rewind, link, data, max_rewind, size, 0)) > 0) {
 		ob->size -= rewind;
+		budget_text(rndr, link->data, link->size);
+		if (rndr->link_hook)
+			report_autolink(rndr, link, MKDA_EMAIL, data - rewind, rewind + link_len);
 		rndr->cb.autolink(ob, link, MKDA_EMAIL, rndr->opaque);
 	}
 
@@ -976,15 +1925,24 @@ static size_t
 char_autolink_url(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset, size_t size)
 {
 	struct buf *link;
-	size_t link_len, rewind;
+	size_t link_len, rewind, max_rewind;
 
 	if (!rndr->cb.autolink || rndr->in_link_body)
 		return 0;
 
+	/* the ':' has to be followed by "//" and preceded by a scheme */
+	max_rewind = autolink_max_rewind(ob, rndr, offset);
+	if (size < 4 || data[1] != '/' || data[2] != '/' ||
+		max_rewind == 0 || !isalpha(data[-1]))
+		return 0;
+
 	link = rndr_newbuf(rndr, BUFFER_SPAN);
 
-	if ((link_len = sd_autolink__url(&rewind, link, data, offset, size, SD_AUTOLINK_SHORT_DOMAINS)) > 0) {
+	if ((link_len = sd_autolink__url(&rewind, link, data, max_rewind, size, SD_AUTOLINK_SHORT_DOMAINS)) > 0) {
 		ob->size -= rewind;
+		budget_text(rndr, link->data, link->size);
+		if (rndr->link_hook)
+			report_link(rndr, MKD_LINK_AUTOLINK, link, NULL, data - rewind, rewind + link_len);
 		rndr->cb.autolink(ob, link, MKDA_NORMAL, rndr->opaque);
 	}
 
@@ -992,11 +1950,422 @@ char_autolink_url(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_
 	return link_len;
 }
 
+/* char_emoji • ':' opening a shortcode of the emoji table, else the
+ * ':' of an autolink */
+static size_t
+char_emoji(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset, size_t size)
+{
+	struct buf name = { 0, 0, 0, 0 }, character = { 0, 0, 0, 0 };
+	const struct emoji *emoji;
+	size_t end = 1;
+
+	/* a shortcode doesn't start in the middle of a word */
+	if (offset == 0 || !_isalnum(data[-1])) {
+		while (end < size && end <= EMOJI_MAX_LENGTH &&
+			(_isalnum(data[end]) || data[end] == '_' || data[end] == '+' || data[end] == '-'))
+			end++;
+
+		if (end > 1 && end < size && data[end] == ':' &&
+			(emoji = find_emoji(data + 1, end - 1)) != NULL) {
+			name.data = data + 1;
+			name.size = end - 1;
+			character.data = (uint8_t *)emoji->character;
+			character.size = strlen(emoji->character);
+
+			budget_text(rndr, data, 1);
+			if (rndr->cb.emoji(ob, &name, &character, rndr->opaque))
+				return end + 1;
+		}
+	}
+
+	if (rndr->ext_flags & MKDEXT_AUTOLINK)
+		return char_autolink_url(ob, rndr, data, offset, size);
+
+	return 0;
+}
+
+/* reference_starts • whether a reference can start at data[0]: not
+ * inside a word, an address or a path */
+static int
+reference_starts(uint8_t *data, size_t offset)
+{
+	return offset == 0 || (!_isalnum(data[-1]) && strchr("._+-/&@#", data[-1]) == NULL);
+}
+
+/* reference_link • links the `size` chars of a reference to the URL
+ * made from `url` and its `name` */
+static size_t
+reference_link(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t size,
+	const uint8_t *name, size_t name_size, const char *url, enum mkd_link_kind kind)
+{
+	struct buf *link, *link_url, *link_text;
+	const char *s;
+	int ret;
+
+	budget_text(rndr, data, size);
+
+	link = rndr_newbuf(rndr, BUFFER_SPAN);
+	bufput(link, data, size);
+
+	link_url = rndr_newbuf(rndr, BUFFER_SPAN);
+	while ((s = strstr(url, "%s")) != NULL) {
+		bufput(link_url, url, s - url);
+		bufput(link_url, name, name_size);
+		url = s + 2;
+	}
+	bufputs(link_url, url);
+
+	if (rndr->link_hook)
+		report_link(rndr, kind, link_url, NULL, data, size);
+
+	if (rndr->cb.normal_text) {
+		link_text = rndr_newbuf(rndr, BUFFER_SPAN);
+		rndr->cb.normal_text(link_text, link, rndr->opaque);
+		ret = rndr->cb.link(ob, link_url, NULL, link_text, rndr->opaque);
+		rndr_popbuf(rndr, BUFFER_SPAN);
+	} else {
+		ret = rndr->cb.link(ob, link_url, NULL, link, rndr->opaque);
+	}
+
+	rndr_popbuf(rndr, BUFFER_SPAN);
+	rndr_popbuf(rndr, BUFFER_SPAN);
+	return ret ? size : 0;
+}
+
+/* char_mention • '@' of a user name, else the '@' of an address */
+static size_t
+char_mention(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset, size_t size)
+{
+	size_t end = 1;
+
+	if (!rndr->in_link_body && reference_starts(data, offset)) {
+		/* a name is made of letters, digits and inner hyphens */
+		while (end < size && (_isalnum(data[end]) || (data[end] == '-' && end > 1)))
+			end++;
+		while (end > 1 && data[end - 1] == '-')
+			end--;
+
+		if (end > 1 && (end == size || (data[end] != '_' && data[end] != '@')))
+			return reference_link(ob, rndr, data, end,
+				data + 1, end - 1, rndr->mention_url, MKD_LINK_MENTION);
+	}
+
+	if (rndr->ext_flags & MKDEXT_AUTOLINK)
+		return char_autolink_email(ob, rndr, data, offset, size);
+
+	return 0;
+}
+
+/* char_issue • '#' of an issue number */
+static size_t
+char_issue(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset, size_t size)
+{
+	size_t end = 1;
+
+	if (rndr->in_link_body || !reference_starts(data, offset))
+		return 0;
+
+	while (end < size && isdigit(data[end]))
+		end++;
+
+	if (end == 1 || (end < size && (_isalnum(data[end]) || data[end] == '_')))
+		return 0;
+
+	return reference_link(ob, rndr, data, end,
+		data + 1, end - 1, rndr->issue_url, MKD_LINK_ISSUE);
+}
+
+/* build_bracket_index • resolves the brackets of a span in one pass */
+/*	a bracket preceded by a backslash doesn't count, but a '[' still
+ *	gets the ']' a scan starting on it would stop at: the first one
+ *	taking the nesting below where it was. For an unescaped '[' that
+ *	is the ']' popping it off the stack of open ones; an escaped one
+ *	waits for the ']' popping whatever was on top when it was met. */
+static void
+build_bracket_index(struct sd_markdown *rndr, struct bracket_index *idx, uint8_t *data, size_t size)
+{
+	uint32_t *open, *waiting, *height;
+	size_t i, j = 0, count = 0, opened = 0, waits = 0;
+
+	idx->built = 1;
+
+	for (i = 0; i < size; ++i) {
+		if (data[i] == '[')
+			count++;
+	}
+
+	if (!count)
+		return;
+
+	if (count > LINK_INDEX_MAX || size >= UINT32_MAX ||
+		!(idx->pos = get_span_table(rndr, TABLE_BRACKETS, 2 * count)) ||
+		!(open = malloc(3 * count * sizeof(uint32_t)))) {
+		idx->pos = NULL;
+		idx->unindexed = 1;
+		return;
+	}
+
+	idx->close = idx->pos + count;
+	idx->count = count;
+	waiting = open + count;
+	height = waiting + count;
+
+	for (i = 0; i < size; ++i) {
+		int active = (i == 0 || data[i - 1] != '\\');
+
+		if (data[i] == '[') {
+			idx->pos[j] = (uint32_t)i;
+			idx->close[j] = 0;
+
+			if (active)
+				open[opened++] = (uint32_t)j;
+			else {
+				waiting[waits] = (uint32_t)j;
+				height[waits++] = (uint32_t)opened;
+			}
+			j++;
+		}
+
+		else if (data[i] == ']' && active) {
+			while (waits && height[waits - 1] == opened)
+				idx->close[waiting[--waits]] = (uint32_t)i;
+
+			if (opened)
+				idx->close[open[--opened]] = (uint32_t)i;
+		}
+	}
+
+	free(open);
+}
+
+/* tail_stop • the closer of two stops, either of which may be 0 */
+static uint32_t
+tail_stop(uint32_t paren, uint32_t quote)
+{
+	return (quote && (!paren || quote < paren)) ? quote : paren;
+}
+
+/* build_tail_index • resolves the link destinations of a span in one pass */
+/*	Inside a link destination a backslash skips the next char; the
+ *	entries are the parens and quotes such a scan can stop on, which
+ *	are the same whichever paren it started after. Parens are matched
+ *	through their nesting level: a destination ends on the first ')'
+ *	where the running level drops below the one it started at, so one
+ *	backward pass remembering the next such ')' of every level answers
+ *	all of them at once. A quote following a space ends it too. */
+static void
+build_tail_index(struct sd_markdown *rndr, struct tail_index *idx, uint8_t *data, size_t size)
+{
+	uint32_t *next_level;
+	uint32_t rpar = 0, squote = 0, dquote = 0, next_quote = 0;
+	size_t i, j, count = 0, parens = 0;
+	long par = 0, before, base;
+	int visited = 1;
+
+	idx->built = 1;
+
+	/* forward pass: the stops and the final nesting level */
+	for (i = 0; i < size; ++i) {
+		visited = (i == 0 || data[i - 1] != '\\' || !visited);
+		if (!visited)
+			continue;
+
+		if (data[i] == '(' || data[i] == ')') {
+			par += (data[i] == '(') ? 1 : -1;
+			parens++;
+			count++;
+		}
+		else if (data[i] == '\'' || data[i] == '"')
+			count++;
+	}
+
+	if (!count)
+		return;
+
+	if (count > LINK_INDEX_MAX || size >= UINT32_MAX ||
+		!(idx->pos = get_span_table(rndr, TABLE_TAILS, 5 * count)) ||
+		!(next_level = calloc(2 * parens + 5, sizeof(uint32_t)))) {
+		idx->pos = NULL;
+		idx->unindexed = 1;
+		return;
+	}
+
+	idx->tail = idx->pos + count;
+	idx->rpar = idx->tail + count;
+	idx->squote = idx->rpar + count;
+	idx->dquote = idx->squote + count;
+	idx->count = count;
+
+	for (i = 0, j = 0; i < size; ++i) {
+		visited = (i == 0 || data[i - 1] != '\\' || !visited);
+		if (visited && (data[i] == '(' || data[i] == ')' || data[i] == '\'' || data[i] == '"'))
+			idx->pos[j++] = (uint32_t)i;
+	}
+
+	/* backward pass; par is the level after the entry, before the
+	 * level a destination starting up to it begins at */
+	base = (long)parens + 2;
+	for (j = count; j-- > 0; ) {
+		i = idx->pos[j];
+		before = par;
+
+		if (data[i] == ')') {
+			next_level[par + base] = (uint32_t)i;
+			rpar = (uint32_t)i;
+			before++;
+		}
+		else if (data[i] == '(')
+			before--;
+		else {
+			if (data[i] == '\'')
+				squote = (uint32_t)i;
+			else
+				dquote = (uint32_t)i;
+
+			/* a quote after a space ends the destination */
+			if (i && _isspace(data[i - 1]))
+				next_quote = (uint32_t)i;
+		}
+
+		idx->tail[j] = tail_stop(next_level[before - 1 + base], next_quote);
+		idx->rpar[j] = rpar;
+		idx->squote[j] = squote;
+		idx->dquote[j] = dquote;
+
+		par = before;
+	}
+
+	free(next_level);
+}
+
+/* find_link_close • looks for the ']' matching the '[' at data[0] */
+/*	the first link of a span is found by scanning forward, which is
+ *	cheaper than building the index; but the scans of nested or broken
+ *	brackets run over the same text again and again, so from the second
+ *	'[' on the index is used instead */
+static size_t
+find_link_close(struct sd_markdown *rndr, uint8_t *data, size_t size)
+{
+	struct inline_span *span = rndr->span;
+	struct bracket_index *idx = &span->brackets;
+	size_t i, pos;
+	int level;
+
+	if (!idx->built && span->link_closes++ > 0)
+		build_bracket_index(rndr, idx, span->data, span->size);
+
+	if (idx->built && !idx->unindexed) {
+		pos = (size_t)(data - span->data);
+		i = first_entry(idx->pos, idx->count, pos);
+
+		if (i == idx->count || idx->pos[i] != pos || !idx->close[i])
+			return 0;
+
+		return idx->close[i] - pos;
+	}
+
+	for (i = 1, level = 1; i < size; i++) {
+		if (data[i - 1] == '\\')
+			continue;
+
+		else if (data[i] == '[')
+			level++;
+
+		else if (data[i] == ']') {
+			level--;
+			if (level <= 0)
+				return i;
+		}
+	}
+
+	return 0;
+}
+
+/* find_link_end • looks for the end of an inline link destination */
+/*	the destination ends on the ')' balancing the parens it opened, or
+ *	on a quote following a space; as with brackets, the index takes
+ *	over from the second destination of a span */
+static size_t
+find_link_end(struct sd_markdown *rndr, uint8_t *data, size_t i, size_t size)
+{
+	struct inline_span *span = rndr->span;
+	struct tail_index *idx = &span->tails;
+	size_t nb_p = 0, pos, j;
+
+	if (!idx->built && span->link_ends++ > 0)
+		build_tail_index(rndr, idx, span->data, span->size);
+
+	if (idx->built && !idx->unindexed) {
+		pos = (size_t)(data - span->data);
+		j = first_entry(idx->pos, idx->count, pos + i);
+
+		return (j < idx->count && idx->tail[j]) ? idx->tail[j] - pos : 0;
+	}
+
+	while (i < size) {
+		if (data[i] == '\\') i += 2;
+		else if (data[i] == '(' && i != 0) {
+			nb_p++; i++;
+		}
+		else if (data[i] == ')') {
+			if (nb_p == 0) return i;
+			else nb_p--; i++;
+		} else if (i >= 1 && _isspace(data[i-1]) && (data[i] == '\'' || data[i] == '"')) return i;
+		else i++;
+	}
+
+	return 0;
+}
+
+/* find_title_end • looks for the ')' following the closing quote of a title */
+static size_t
+find_title_end(struct sd_markdown *rndr, uint8_t *data, size_t i, size_t size, uint8_t qtype)
+{
+	struct inline_span *span = rndr->span;
+	struct tail_index *idx = &span->tails;
+	size_t pos, j;
+	uint32_t quote;
+	int in_title = 1;
+
+	if (idx->built && !idx->unindexed) {
+		pos = (size_t)(data - span->data);
+		j = first_entry(idx->pos, idx->count, pos + i);
+		if (j == idx->count)
+			return 0;
+
+		quote = (qtype == '"') ? idx->dquote[j] : idx->squote[j];
+		if (!quote)
+			return 0;
+
+		j = first_entry(idx->pos, idx->count, quote + 1);
+		return (j < idx->count && idx->rpar[j]) ? idx->rpar[j] - pos : 0;
+	}
+
+	while (i < size) {
+		if (data[i] == '\\') i += 2;
+		else if (data[i] == qtype) {in_title = 0; i++;}
+		else if ((data[i] == ')') && !in_title) return i;
+		else i++;
+	}
+
+	return 0;
+}
+
+/* link_text_names_ref • whether a link text could be the name of a reference */
+/*	nested brackets make every text of a span a candidate, so texts
+ *	too long for any name are turned down before being copied or
+ *	hashed; joining the lines of one takes out at most every other char */
+static int
+link_text_names_ref(struct sd_markdown *rndr, size_t size)
+{
+	return rndr->refs.count && size <= 2 * rndr->refs.longest;
+}
+
 /* char_link • '[': parsing a link or an image */
 static size_t
 char_link(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset, size_t size)
 {
-	int is_img = (offset && data[-1] == '!'), level;
+	int is_img = (offset && data[-1] == '!');
 	size_t i = 1, txt_e, link_b = 0, link_e = 0, title_b = 0, title_e = 0;
 	struct buf *content = 0;
 	struct buf *link = 0;
@@ -1004,35 +2373,18 @@ char_link(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset
 	struct buf *u_link = 0;
 	size_t org_work_size = rndr->work_bufs[BUFFER_SPAN].size;
 	int text_has_nl = 0, ret = 0;
-	int in_title = 0, qtype = 0;
+	enum mkd_link_kind kind = MKD_LINK_REFERENCE;
 
 	/* checking whether the correct renderer exists */
 	if ((is_img && !rndr->cb.image) || (!is_img && !rndr->cb.link))
 		goto cleanup;
 
 	/* looking for the matching closing bracket */
-	for (level = 1; i < size; i++) {
-		if (data[i] == '\n')
-			text_has_nl = 1;
-
-		else if (data[i - 1] == '\\')
-			continue;
-
-		else if (data[i] == '[')
-			level++;
-
-		else if (data[i] == ']') {
-			level--;
-			if (level <= 0)
-				break;
-		}
-	}
-
-	if (i >= size)
+	txt_e = find_link_close(rndr, data, size);
+	if (!txt_e)
 		goto cleanup;
 
-	txt_e = i;
-	i++;
+	i = txt_e + 1;
 
 	/* footnote link */
 	if (rndr->ext_flags & MKDEXT_FOOTNOTES && data[1] == '^') {
@@ -1045,15 +2397,11 @@ char_link(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset
 		id.data = data + 2;
 		id.size = txt_e - 2;
 
-		fr = find_footnote_ref(&rndr->footnotes_found, id.data, id.size);
+		fr = find_footnote_ref(&rndr->footnotes, id.data, id.size);
 
 		/* mark footnote used */
-		if (fr && !fr->is_used) {
-			if(!add_footnote_ref(&rndr->footnotes_used, fr))
-				goto cleanup;
-			fr->is_used = 1;
-			fr->num = rndr->footnotes_used.count;
-		}
+		if (fr)
+			use_footnote_ref(&rndr->footnotes, fr);
 
 		/* render */
 		if (fr && rndr->cb.footnote_ref)
@@ -1069,6 +2417,8 @@ char_link(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset
 
 	/* inline style link */
 	if (i < size && data[i] == '(') {
+		kind = MKD_LINK_INLINE;
+
 		/* skipping initial whitespace */
 		i++;
 
@@ -1078,39 +2428,18 @@ char_link(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset
 		link_b = i;
 
 		/* looking for link end: ' " ) */
-		/* Count the number of open parenthesis */
-		size_t nb_p = 0;
-
-		while (i < size) {
-			if (data[i] == '\\') i += 2;
-			else if (data[i] == '(' && i != 0) {
-				nb_p++; i++;
-			}
-			else if (data[i] == ')') {
-				if (nb_p == 0) break;
-				else nb_p--; i++;
-			} else if (i >= 1 && _isspace(data[i-1]) && (data[i] == '\'' || data[i] == '"')) break;
-			else i++;
-		}
+		i = find_link_end(rndr, data, i, size);
 
-		if (i >= size) goto cleanup;
+		if (!i) goto cleanup;
 		link_e = i;
 
 		/* looking for title end if present */
 		if (data[i] == '\'' || data[i] == '"') {
-			qtype = data[i];
-			in_title = 1;
 			i++;
 			title_b = i;
 
-			while (i < size) {
-				if (data[i] == '\\') i += 2;
-				else if (data[i] == qtype) {in_title = 0; i++;}
-				else if ((data[i] == ')') && !in_title) break;
-				else i++;
-			}
-
-			if (i >= size) goto cleanup;
+			i = find_title_end(rndr, data, i, size, data[link_e]);
+			if (!i) goto cleanup;
 
 			/* skipping whitespaces after title */
 			title_e = i - 1;
@@ -1160,6 +2489,10 @@ char_link(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset
 
 		/* finding the link_ref */
 		if (link_b == link_e) {
+			if (!link_text_names_ref(rndr, txt_e - 1))
+				goto cleanup;
+
+			text_has_nl = (memchr(data + 1, '\n', txt_e - 1) != NULL);
 			if (text_has_nl) {
 				struct buf *b = rndr_newbuf(rndr, BUFFER_SPAN);
 				size_t j;
@@ -1182,7 +2515,7 @@ char_link(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset
 			id.size = link_e - link_b;
 		}
 
-		lr = find_link_ref(rndr->refs, id.data, id.size);
+		lr = find_link_ref(&rndr->refs, id.data, id.size);
 		if (!lr)
 			goto cleanup;
 
@@ -1197,7 +2530,11 @@ char_link(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset
 		struct buf id = { 0, 0, 0, 0 };
 		struct link_ref *lr;
 
+		if (!link_text_names_ref(rndr, txt_e - 1))
+			goto cleanup;
+
 		/* crafting the id */
+		text_has_nl = (memchr(data + 1, '\n', txt_e - 1) != NULL);
 		if (text_has_nl) {
 			struct buf *b = rndr_newbuf(rndr, BUFFER_SPAN);
 			size_t j;
@@ -1217,7 +2554,7 @@ char_link(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset
 		}
 
 		/* finding the link_ref */
-		lr = find_link_ref(rndr->refs, id.data, id.size);
+		lr = find_link_ref(&rndr->refs, id.data, id.size);
 		if (!lr)
 			goto cleanup;
 
@@ -1229,6 +2566,19 @@ char_link(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset
 		i = txt_e + 1;
 	}
 
+	if (link) {
+		u_link = rndr_newbuf(rndr, BUFFER_SPAN);
+		unscape_text(u_link, link);
+	}
+
+	/* reported before the content, which can hold images of its own */
+	if (rndr->link_hook) {
+		if (is_img)
+			report_link(rndr, MKD_LINK_IMAGE, u_link, title, data - 1, i + 1);
+		else
+			report_link(rndr, kind, u_link, title, data, i);
+	}
+
 	/* building content: img alt is escaped, link content is parsed */
 	if (txt_e > 1) {
 		content = rndr_newbuf(rndr, BUFFER_SPAN);
@@ -1243,11 +2593,6 @@ char_link(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t offset
 		}
 	}
 
-	if (link) {
-		u_link = rndr_newbuf(rndr, BUFFER_SPAN);
-		unscape_text(u_link, link);
-	}
-
 	/* calling the relevant rendering function */
 	if (is_img) {
 		if (ob->size && ob->data[ob->size - 1] == '!')
@@ -1569,6 +2914,174 @@ prefix_uli(uint8_t *data, size_t size)
 }
 
 
+/* line_maybe • classes a line can have, by its first non-space char */
+static const uint16_t line_maybe[256] = {
+	['\n'] = LINE_EMPTY,
+	[' '] = LINE_EMPTY,
+	['#'] = LINE_ATXHEADER,
+	['>'] = LINE_QUOTE,
+	['*'] = LINE_HRULE | LINE_ULI,
+	['-'] = LINE_HRULE | LINE_ULI | LINE_SETEXT,
+	['_'] = LINE_HRULE,
+	['+'] = LINE_ULI,
+	['='] = LINE_SETEXT,
+	['`'] = LINE_FENCE,
+	['~'] = LINE_FENCE,
+	['0'] = LINE_OLI, ['1'] = LINE_OLI, ['2'] = LINE_OLI, ['3'] = LINE_OLI,
+	['4'] = LINE_OLI, ['5'] = LINE_OLI, ['6'] = LINE_OLI, ['7'] = LINE_OLI,
+	['8'] = LINE_OLI, ['9'] = LINE_OLI
+};
+
+/* push_block_lines • starts the index of a text about to be parsed */
+/*	lines are indexed as the block parsers first reach them, and stacked
+ *	in a pool kept by the renderer so nested blocks reuse its memory */
+static void
+push_block_lines(struct sd_markdown *rndr, struct block_lines *lines, uint8_t *data, size_t size)
+{
+	lines->data = data;
+	lines->size = size;
+	lines->first = rndr->line_pool_size;
+	lines->count = 0;
+	lines->end = 0;
+	lines->cur = 0;
+
+	memset(lines->html_miss, 0x0, sizeof(lines->html_miss));
+	lines->html_miss_next = 0;
+}
+
+/* pop_block_lines • releases the index of the innermost text */
+static void
+pop_block_lines(struct sd_markdown *rndr, struct block_lines *lines)
+{
+	rndr->line_pool_size = lines->first;
+}
+
+/* index_line • appends the next line of the text to its index */
+static int
+index_line(struct sd_markdown *rndr, struct block_lines *lines)
+{
+	struct line_info *line;
+	uint8_t *data = lines->data, *nl;
+	size_t beg = lines->end, size = lines->size;
+	size_t i;
+
+	if (rndr->line_pool_size >= rndr->line_pool_asize) {
+		size_t neoasz = rndr->line_pool_asize ? rndr->line_pool_asize * 2 : 64;
+		struct line_info *neopool = realloc(rndr->line_pool, neoasz * sizeof(struct line_info));
+
+		if (!neopool)
+			return 0;
+
+		rndr->line_pool = neopool;
+		rndr->line_pool_asize = neoasz;
+	}
+
+	line = &rndr->line_pool[rndr->line_pool_size++];
+	line->beg = beg;
+
+	for (i = 0; i < 4 && beg + i < size && data[beg + i] == ' '; i++);
+	line->indent = (uint8_t)i;
+	line->maybe = (beg + i < size) ? line_maybe[data[beg + i]] : LINE_EMPTY;
+
+	if (i == 4)
+		line->maybe = LINE_CODE | (line->maybe & LINE_EMPTY);
+	else if (i > 0)
+		line->maybe &= ~(LINE_ATXHEADER | LINE_SETEXT);
+
+	nl = memchr(data + beg, '\n', size - beg);
+	lines->end = nl ? (size_t)(nl - data) + 1 : size;
+	lines->count++;
+	return 1;
+}
+
+/* find_line • returns the line of the current index starting at data */
+static inline struct line_info *
+find_line(struct sd_markdown *rndr, uint8_t *data)
+{
+	struct block_lines *lines = rndr->lines;
+	struct line_info *pool;
+	size_t off, lo, hi;
+
+	if (!lines || data < lines->data || data >= lines->data + lines->size)
+		return NULL;
+
+	off = (size_t)(data - lines->data);
+
+	while (lines->end <= off)
+		if (!index_line(rndr, lines))
+			return NULL;
+
+	pool = rndr->line_pool + lines->first;
+
+	/* the block parsers mostly walk forward one line at a time */
+	if (pool[lines->cur].beg == off)
+		return &pool[lines->cur];
+
+	if (lines->cur + 1 < lines->count && pool[lines->cur + 1].beg == off) {
+		lines->cur++;
+		return &pool[lines->cur];
+	}
+
+	lo = 0;
+	hi = lines->count;
+	while (lo + 1 < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (pool[mid].beg <= off)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	/* not the beginning of a line */
+	if (pool[lo].beg != off)
+		return NULL;
+
+	lines->cur = lo;
+	return &pool[lo];
+}
+
+/* line_indent • returns the number of leading spaces of a line, up to 4 */
+static inline size_t
+line_indent(struct line_info *line, uint8_t *data, size_t size)
+{
+	size_t i = 0;
+
+	if (line)
+		return line->indent;
+
+	while (i < 4 && i < size && data[i] == ' ')
+		i++;
+
+	return i;
+}
+
+/* line_end • returns the offset following the line at data */
+static inline size_t
+line_end(struct sd_markdown *rndr, struct line_info *line, uint8_t *data, size_t size)
+{
+	uint8_t *nl;
+
+	if (line) {
+		struct block_lines *lines = rndr->lines;
+		size_t end = (line + 1 < rndr->line_pool + lines->first + lines->count) ?
+			line[1].beg : lines->end;
+
+		end -= line->beg;
+		return end < size ? end : size;
+	}
+
+	nl = memchr(data, '\n', size);
+	return nl ? (size_t)(nl - data) + 1 : size;
+}
+
+/* line_may_be • returns whether the line can have one of the given classes */
+static inline int
+line_may_be(struct line_info *line, unsigned int mask)
+{
+	return !line || (line->maybe & mask) != 0;
+}
+
 /* parse_block • parsing of one block, returning next uint8_t to parse */
 static void parse_block(struct buf *ob, struct sd_markdown *rndr,
 			uint8_t *data, size_t size);
@@ -1585,15 +3098,17 @@ parse_blockquote(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t
 	out = rndr_newbuf(rndr, BUFFER_BLOCK);
 	beg = 0;
 	while (beg < size) {
-		for (end = beg + 1; end < size && data[end - 1] != '\n'; end++);
+		struct line_info *line = find_line(rndr, data + beg);
+
+		end = beg + line_end(rndr, line, data + beg, size - beg);
 
-		pre = prefix_quote(data + beg, end - beg);
+		pre = line_may_be(line, LINE_QUOTE) ? prefix_quote(data + beg, end - beg) : 0;
 
 		if (pre)
 			beg += pre; /* skipping prefix */
 
 		/* empty line followed by non-quote line */
-		else if (is_empty(data + beg, end - beg) &&
+		else if (line_may_be(line, LINE_EMPTY) && is_empty(data + beg, end - beg) &&
 				(end >= size || (prefix_quote(data + end, size - end) == 0 &&
 				!is_empty(data + end, size - end))))
 			break;
@@ -1628,19 +3143,22 @@ parse_paragraph(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t
 	struct buf work = { data, 0, 0, 0 };
 
 	while (i < size) {
-		for (end = i + 1; end < size && data[end - 1] != '\n'; end++) /* empty */;
+		struct line_info *line = find_line(rndr, data + i);
 
-		if (is_empty(data + i, size - i))
+		end = i + line_end(rndr, line, data + i, size - i);
+
+		if (line_may_be(line, LINE_EMPTY) && is_empty(data + i, size - i))
 			break;
 
-		if (!last_is_empty && (level = is_headerline(data + i, size - i)) != 0)
+		if (!last_is_empty && line_may_be(line, LINE_SETEXT) &&
+			(level = is_headerline(data + i, size - i)) != 0)
 			break;
 
 		last_is_empty = 0;
 
-		if (is_atxheader(rndr, data + i, size - i) ||
-			is_hrule(data + i, size - i) ||
-			prefix_quote(data + i, size - i)) {
+		if ((line_may_be(line, LINE_ATXHEADER) && is_atxheader(rndr, data + i, size - i)) ||
+			(line_may_be(line, LINE_HRULE) && is_hrule(data + i, size - i)) ||
+			(line_may_be(line, LINE_QUOTE) && prefix_quote(data + i, size - i))) {
 			end = i;
 			break;
 		}
@@ -1655,8 +3173,8 @@ parse_paragraph(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t
 		 * here
 		 */
 		if ((rndr->ext_flags & MKDEXT_LAX_SPACING) && !isalpha(data[i])) {
-			if (prefix_oli(data + i, size - i) ||
-				prefix_uli(data + i, size - i)) {
+			if ((line_may_be(line, LINE_OLI) && prefix_oli(data + i, size - i)) ||
+				(line_may_be(line, LINE_ULI) && prefix_uli(data + i, size - i))) {
 				end = i;
 				break;
 			}
@@ -1670,6 +3188,7 @@ parse_paragraph(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t
 
 			/* see if a code fence starts here */
 			if ((rndr->ext_flags & MKDEXT_FENCED_CODE) != 0 &&
+				line_may_be(line, LINE_FENCE) &&
 				is_codefence(data + i, size - i, NULL) != 0) {
 				end = i;
 				break;
@@ -1691,6 +3210,7 @@ parse_paragraph(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t
 		rndr_popbuf(rndr, BUFFER_BLOCK);
 	} else {
 		struct buf *header_work;
+		size_t offset = SD_NO_OFFSET;
 
 		if (work.size) {
 			size_t beg;
@@ -1718,9 +3238,16 @@ parse_paragraph(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t
 			else work.size = i;
 		}
 
+		/* looked for before the links of the header move the search on */
+		if (rndr->header_hook)
+			offset = find_source(rndr, work.data, work.size);
+
 		header_work = rndr_newbuf(rndr, BUFFER_SPAN);
 		parse_inline(header_work, rndr, work.data, work.size);
 
+		if (rndr->header_hook)
+			report_header(rndr, header_work, level, offset);
+
 		if (rndr->cb.header)
 			rndr->cb.header(ob, header_work, (int)level, rndr->opaque);
 
@@ -1734,18 +3261,23 @@ parse_paragraph(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t
 static size_t
 parse_fencedcode(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t size)
 {
-	size_t beg, end;
+	size_t beg, end, code_size;
 	struct buf *work = 0;
+	struct buf text = { 0, 0, 0, 0 };
 	struct buf lang = { 0, 0, 0, 0 };
 
 	beg = is_codefence(data, size, &lang);
 	if (beg == 0) return 0;
 
-	work = rndr_newbuf(rndr, BUFFER_BLOCK);
+	/* the code is compacted in place: lines only ever shrink
+	 * (blank lines become a bare newline), so it is moved back
+	 * over the opening fence instead of being copied out */
+	text.data = data + beg;
 
 	while (beg < size) {
 		size_t fence_end;
 		struct buf fence_trail = { 0, 0, 0, 0 };
+		struct line_info *line;
 
 		fence_end = is_codefence(data + beg, size - beg, &fence_trail);
 		if (fence_end != 0 && fence_trail.size == 0) {
@@ -1753,25 +3285,43 @@ parse_fencedcode(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t
 			break;
 		}
 
-		for (end = beg + 1; end < size && data[end - 1] != '\n'; end++);
+		line = find_line(rndr, data + beg);
+		end = beg + line_end(rndr, line, data + beg, size - beg);
 
 		if (beg < end) {
-			/* verbatim copy to the working buffer,
-				escaping entities */
-			if (is_empty(data + beg, end - beg))
-				bufputc(work, '\n');
-			else bufput(work, data + beg, end - beg);
+			if (line_may_be(line, LINE_EMPTY) && is_empty(data + beg, end - beg))
+				text.data[text.size++] = '\n';
+			else {
+				if (text.data + text.size != data + beg)
+					memmove(text.data + text.size, data + beg, end - beg);
+				text.size += end - beg;
+			}
 		}
 		beg = end;
 	}
 
-	if (work->size && work->data[work->size - 1] != '\n')
-		bufputc(work, '\n');
+	/* an unterminated last line needs one more byte; only copy
+	 * out when compaction left no room for it */
+	if (text.size && text.data[text.size - 1] != '\n') {
+		if (text.data + text.size < data + beg)
+			text.data[text.size++] = '\n';
+		else {
+			work = rndr_newbuf(rndr, BUFFER_BLOCK);
+			bufput(work, text.data, text.size);
+			bufputc(work, '\n');
+			text = *work;
+		}
+	}
 
-	if (rndr->cb.blockcode)
-		rndr->cb.blockcode(ob, work, lang.size ? &lang : NULL, rndr->opaque);
+	code_size = text.size;
+	text.size = budget_text(rndr, text.data, text.size);
 
-	rndr_popbuf(rndr, BUFFER_BLOCK);
+	/* unless max_text left nothing of it */
+	if (rndr->cb.blockcode && (text.size || !code_size))
+		rndr->cb.blockcode(ob, &text, lang.size ? &lang : NULL, rndr->opaque);
+
+	if (work)
+		rndr_popbuf(rndr, BUFFER_BLOCK);
 	return beg;
 }
 
@@ -1785,12 +3335,14 @@ parse_blockcode(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t
 
 	beg = 0;
 	while (beg < size) {
-		for (end = beg + 1; end < size && data[end - 1] != '\n'; end++) {};
-		pre = prefix_code(data + beg, end - beg);
+		struct line_info *line = find_line(rndr, data + beg);
+
+		end = beg + line_end(rndr, line, data + beg, size - beg);
+		pre = line_may_be(line, LINE_CODE) ? prefix_code(data + beg, end - beg) : 0;
 
 		if (pre)
 			beg += pre; /* skipping prefix */
-		else if (!is_empty(data + beg, end - beg))
+		else if (!line_may_be(line, LINE_EMPTY) || !is_empty(data + beg, end - beg))
 			/* non-empty non-prefixed line breaks the pre */
 			break;
 
@@ -1808,8 +3360,9 @@ parse_blockcode(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t
 		work->size -= 1;
 
 	bufputc(work, '\n');
+	work->size = budget_text(rndr, work->data, work->size);
 
-	if (rndr->cb.blockcode)
+	if (rndr->cb.blockcode && work->size)
 		rndr->cb.blockcode(ob, work, NULL, rndr->opaque);
 
 	rndr_popbuf(rndr, BUFFER_BLOCK);
@@ -1821,7 +3374,8 @@ parse_blockcode(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t
 static size_t
 parse_listitem(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t size, int *flags)
 {
-	struct buf *work = 0, *inter = 0;
+	struct buf *inter = 0;
+	struct buf work = { 0, 0, 0, 0 };
 	size_t beg = 0, end, pre, sublist = 0, orgpre = 0, i;
 	int in_empty = 0, has_inside_empty = 0, in_fence = 0;
 
@@ -1841,35 +3395,33 @@ parse_listitem(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t s
 	while (end < size && data[end - 1] != '\n')
 		end++;
 
-	/* getting working buffers */
-	work = rndr_newbuf(rndr, BUFFER_SPAN);
 	inter = rndr_newbuf(rndr, BUFFER_SPAN);
 
-	/* putting the first line into the working buffer */
-	bufput(work, data + beg, end - beg);
+	/* the item content is compacted in place, the same way
+	 * parse_blockquote does: every line is moved back over the
+	 * prefixes already consumed, so `work` never outruns the
+	 * line being read and no copy of the item is made */
+	work.data = data + beg;
+	work.size = end - beg;
 	beg = end;
 
 	/* process the following lines */
 	while (beg < size) {
 		size_t has_next_uli = 0, has_next_oli = 0;
+		struct line_info *line;
 
-		end++;
-
-		while (end < size && data[end - 1] != '\n')
-			end++;
+		line = find_line(rndr, data + beg);
+		end = beg + line_end(rndr, line, data + beg, size - beg);
 
 		/* process an empty line */
-		if (is_empty(data + beg, end - beg)) {
+		if (line_may_be(line, LINE_EMPTY) && is_empty(data + beg, end - beg)) {
 			in_empty = 1;
 			beg = end;
 			continue;
 		}
 
 		/* calculating the indentation */
-		i = 0;
-		while (i < 4 && beg + i < end && data[beg + i] == ' ')
-			i++;
-
+		i = line_indent(line, data + beg, end - beg);
 		pre = i;
 
 		if (rndr->ext_flags & MKDEXT_FENCED_CODE) {
@@ -1901,7 +3453,7 @@ parse_listitem(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t s
 				break;             /* the same indentation */
 
 			if (!sublist)
-				sublist = work->size;
+				sublist = work.size;
 		}
 		/* joining only indented stuff after empty lines */
 		else if (in_empty && i < 4 && data[beg] != '\t') {
@@ -1909,14 +3461,17 @@ parse_listitem(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t s
 			break;
 		}
 		else if (in_empty) {
-			bufputc(work, '\n');
+			/* the skipped empty lines leave room for this */
+			work.data[work.size++] = '\n';
 			has_inside_empty = 1;
 		}
 
 		in_empty = 0;
 
-		/* adding the line without prefix into the working buffer */
-		bufput(work, data + beg + i, end - beg - i);
+		/* moving the line without prefix into the working area */
+		if (work.data + work.size != data + beg + i)
+			memmove(work.data + work.size, data + beg + i, end - beg - i);
+		work.size += end - beg - i;
 		beg = end;
 	}
 
@@ -1926,27 +3481,26 @@ parse_listitem(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t s
 
 	if (*flags & MKD_LI_BLOCK) {
 		/* intermediate render of block li */
-		if (sublist && sublist < work->size) {
-			parse_block(inter, rndr, work->data, sublist);
-			parse_block(inter, rndr, work->data + sublist, work->size - sublist);
+		if (sublist && sublist < work.size) {
+			parse_block(inter, rndr, work.data, sublist);
+			parse_block(inter, rndr, work.data + sublist, work.size - sublist);
 		}
 		else
-			parse_block(inter, rndr, work->data, work->size);
+			parse_block(inter, rndr, work.data, work.size);
 	} else {
 		/* intermediate render of inline li */
-		if (sublist && sublist < work->size) {
-			parse_inline(inter, rndr, work->data, sublist);
-			parse_block(inter, rndr, work->data + sublist, work->size - sublist);
+		if (sublist && sublist < work.size) {
+			parse_inline(inter, rndr, work.data, sublist);
+			parse_block(inter, rndr, work.data + sublist, work.size - sublist);
 		}
 		else
-			parse_inline(inter, rndr, work->data, work->size);
+			parse_inline(inter, rndr, work.data, work.size);
 	}
 
 	/* render of li itself */
 	if (rndr->cb.listitem)
 		rndr->cb.listitem(ob, inter, *flags, rndr->opaque);
 
-	rndr_popbuf(rndr, BUFFER_SPAN);
 	rndr_popbuf(rndr, BUFFER_SPAN);
 	return beg;
 }
@@ -1962,10 +3516,16 @@ parse_list(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t size,
 	work = rndr_newbuf(rndr, BUFFER_BLOCK);
 
 	while (i < size) {
+		size_t written = work->size, text_chars = rndr->text_chars;
+
 		j = parse_listitem(work, rndr, data + i, size - i, &flags);
 		i += j;
 
-		if (!j || (flags & MKD_LI_END))
+		/* an item max_text has cut down to nothing is taken back */
+		if (rndr->stopped == MKD_STOP_TEXT && rndr->text_chars == text_chars)
+			work->size = written;
+
+		if (!j || (flags & MKD_LI_END) || rndr->stopped)
 			break;
 	}
 
@@ -1998,9 +3558,16 @@ parse_atxheader(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t
 
 	if (end > i) {
 		struct buf *work = rndr_newbuf(rndr, BUFFER_SPAN);
+		size_t offset = SD_NO_OFFSET;
+
+		if (rndr->header_hook)
+			offset = find_source(rndr, data, end);
 
 		parse_inline(work, rndr, data + i, end - i);
 
+		if (rndr->header_hook)
+			report_header(rndr, work, level, offset);
+
 		if (rndr->cb.header)
 			rndr->cb.header(ob, work, (int)level, rndr->opaque);
 
@@ -2029,19 +3596,18 @@ static void
 parse_footnote_list(struct buf *ob, struct sd_markdown *rndr, struct footnote_list *footnotes)
 {
 	struct buf *work = 0;
-	struct footnote_item *item;
 	struct footnote_ref *ref;
+	unsigned int i;
 
-	if (footnotes->count == 0)
+	if (footnotes->used_count == 0)
 		return;
 
 	work = rndr_newbuf(rndr, BUFFER_BLOCK);
 
-	item = footnotes->head;
-	while (item) {
-		ref = item->ref;
+	for (i = 0; i < footnotes->used_count; ++i) {
+		ref = &footnotes->items[footnotes->used[i]];
+		rndr->src_cursor = ref->src_offset;
 		parse_footnote_def(work, rndr, ref->num, ref->contents->data, ref->contents->size);
-		item = item->next;
 	}
 
 	if (rndr->cb.footnotes)
@@ -2081,53 +3647,91 @@ htmlblock_end_tag(
 	return i + w;
 }
 
+/* htmlblock_end • finds the closers of an HTML block in one pass */
+/*	returns the end of the first unindented closer (or of one still
+ *	on the opening line), 0 if none; `indented` is then set to the end
+ *	of the first indented closer, or 0 */
 static size_t
 htmlblock_end(const char *curtag,
 	struct sd_markdown *rndr,
 	uint8_t *data,
 	size_t size,
-	int start_of_line)
+	size_t *indented)
 {
 	size_t tag_size = strlen(curtag);
-	size_t i = 1, end_tag;
-	int block_lines = 0;
+	size_t i = 1, end_tag, first_nl;
+	uint8_t *p;
 
-	while (i < size) {
-		i++;
-		while (i < size && !(data[i - 1] == '<' && data[i] == '/')) {
-			if (data[i] == '\n')
-				block_lines++;
+	*indented = 0;
 
-			i++;
-		}
+	p = memchr(data, '\n', size);
+	first_nl = p ? (size_t)(p - data) : size;
 
-		/* If we are only looking for unindented tags, skip the tag
-		 * if it doesn't follow a newline.
-		 *
-		 * The only exception to this is if the tag is still on the
-		 * initial line; in that case it still counts as a closing
-		 * tag
-		 */
-		if (start_of_line && block_lines > 0 && data[i - 2] != '\n')
-			continue;
+	while (i < size && (p = memchr(data + i, '<', size - i)) != NULL) {
+		i = p - data;
 
-		if (i + 2 + tag_size >= size)
+		if (i + 3 + tag_size >= size)
 			break;
 
-		end_tag = htmlblock_end_tag(curtag, tag_size, rndr, data + i - 1, size - i + 1);
-		if (end_tag)
-			return i + end_tag - 1;
+		if (data[i + 1] == '/') {
+			end_tag = htmlblock_end_tag(curtag, tag_size, rndr, data + i, size - i);
+
+			if (end_tag) {
+				if (i < first_nl || data[i - 1] == '\n')
+					return i + end_tag;
+
+				if (!*indented)
+					*indented = i + end_tag;
+			}
+		}
+
+		i++;
+	}
+
+	return 0;
+}
+
+/* htmlblock_miss • whether `curtag` is known to have no closer
+ * in the rest of the text being parsed from `data` on */
+static int
+htmlblock_miss(struct sd_markdown *rndr, const char *curtag, uint8_t *data, size_t size)
+{
+	struct block_lines *lines = rndr->lines;
+	size_t from, i;
+
+	if (!lines || data < lines->data || data + size != lines->data + lines->size)
+		return 0;
+
+	from = data - lines->data;
+	for (i = 0; i < HTML_MISS_SLOTS; ++i) {
+		if (lines->html_miss[i].tag == curtag && lines->html_miss[i].from <= from)
+			return 1;
 	}
 
 	return 0;
 }
 
+/* htmlblock_record_miss • remembers that `curtag` has no closer
+ * from `data` to the end of the text being parsed */
+static void
+htmlblock_record_miss(struct sd_markdown *rndr, const char *curtag, uint8_t *data, size_t size)
+{
+	struct block_lines *lines = rndr->lines;
+	struct html_miss *miss;
+
+	if (!lines || data < lines->data || data + size != lines->data + lines->size)
+		return;
+
+	miss = &lines->html_miss[lines->html_miss_next++ % HTML_MISS_SLOTS];
+	miss->tag = curtag;
+	miss->from = data - lines->data;
+}
 
 /* parse_htmlblock • parsing of inline HTML block */
 static size_t
 parse_htmlblock(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t size, int do_render)
 {
-	size_t i, j = 0, tag_end;
+	size_t i, j = 0, tag_end, indented_end;
 	const char *curtag = NULL;
 	struct buf work = { data, 0, 0, 0 };
 
@@ -2187,16 +3791,25 @@ parse_htmlblock(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t
 		return 0;
 	}
 
+	/* a tag already known to be unclosed further up the text
+	 * is unclosed from here on too */
+	if (htmlblock_miss(rndr, curtag, data, size))
+		return 0;
+
 	/* looking for an unindented matching closing tag */
 	/*	followed by a blank line */
-	tag_end = htmlblock_end(curtag, rndr, data, size, 1);
+	tag_end = htmlblock_end(curtag, rndr, data, size, &indented_end);
 
-	/* if not found, trying a second pass looking for indented match */
-	/* but not if tag is "ins" or "del" (following original Markdown.pl) */
-	if (!tag_end && strcmp(curtag, "ins") != 0 && strcmp(curtag, "del") != 0) {
-		tag_end = htmlblock_end(curtag, rndr, data, size, 0);
+	if (!tag_end && !indented_end) {
+		htmlblock_record_miss(rndr, curtag, data, size);
+		return 0;
 	}
 
+	/* if not found, falling back on an indented match */
+	/* but not if tag is "ins" or "del" (following original Markdown.pl) */
+	if (!tag_end && strcmp(curtag, "ins") != 0 && strcmp(curtag, "del") != 0)
+		tag_end = indented_end;
+
 	if (!tag_end)
 		return 0;
 
@@ -2216,24 +3829,22 @@ parse_table_row(
 	size_t size,
 	size_t columns,
 	int *col_data,
-	int header_flag)
+	int header_flag,
+	struct buf *row_work,
+	struct buf *cell_work)
 {
 	size_t i = 0, col;
-	struct buf *row_work = 0;
 
 	if (!rndr->cb.table_cell || !rndr->cb.table_row)
 		return;
 
-	row_work = rndr_newbuf(rndr, BUFFER_SPAN);
+	row_work->size = 0;
 
 	if (i < size && data[i] == '|')
 		i++;
 
 	for (col = 0; col < columns && i < size; ++col) {
 		size_t cell_start, cell_end;
-		struct buf *cell_work;
-
-		cell_work = rndr_newbuf(rndr, BUFFER_SPAN);
 
 		while (i < size && _isspace(data[i]))
 			i++;
@@ -2248,10 +3859,10 @@ parse_table_row(
 		while (cell_end > cell_start && _isspace(data[cell_end]))
 			cell_end--;
 
+		cell_work->size = 0;
 		parse_inline(cell_work, rndr, data + cell_start, 1 + cell_end - cell_start);
 		rndr->cb.table_cell(row_work, cell_work, col_data[col] | header_flag, rndr->opaque);
 
-		rndr_popbuf(rndr, BUFFER_SPAN);
 		i++;
 	}
 
@@ -2261,20 +3872,18 @@ parse_table_row(
 	}
 
 	rndr->cb.table_row(ob, row_work, rndr->opaque);
-
-	rndr_popbuf(rndr, BUFFER_SPAN);
 }
 
 static size_t
 parse_table_header(
-	struct buf *ob,
 	struct sd_markdown *rndr,
 	uint8_t *data,
 	size_t size,
 	size_t *columns,
-	int **column_data)
+	size_t *header_size)
 {
 	int pipes;
+	int *column_data;
 	size_t i = 0, col, header_end, under_end;
 
 	pipes = 0;
@@ -2297,7 +3906,22 @@ parse_table_header(
 		pipes--;
 
 	*columns = pipes + 1;
-	*column_data = calloc(*columns, sizeof(int));
+	*header_size = header_end;
+
+	/* the column flags live in the renderer and are reused
+	 * by every table; only one table is ever parsed at once */
+	if (*columns > rndr->table_cols_asize) {
+		int *neocols = realloc(rndr->table_cols, *columns * sizeof(int));
+
+		if (!neocols)
+			return 0;
+
+		rndr->table_cols = neocols;
+		rndr->table_cols_asize = *columns;
+	}
+
+	column_data = rndr->table_cols;
+	memset(column_data, 0x0, *columns * sizeof(int));
 
 	/* Parse the header underline */
 	i++;
@@ -2315,7 +3939,7 @@ parse_table_header(
 			i++;
 
 		if (data[i] == ':') {
-			i++; (*column_data)[col] |= MKD_TABLE_ALIGN_L;
+			i++; column_data[col] |= MKD_TABLE_ALIGN_L;
 			dashes++;
 		}
 
@@ -2324,7 +3948,7 @@ parse_table_header(
 		}
 
 		if (i < under_end && data[i] == ':') {
-			i++; (*column_data)[col] |= MKD_TABLE_ALIGN_R;
+			i++; column_data[col] |= MKD_TABLE_ALIGN_R;
 			dashes++;
 		}
 
@@ -2343,14 +3967,6 @@ parse_table_header(
 	if (col < *columns)
 		return 0;
 
-	parse_table_row(
-		ob, rndr, data,
-		header_end,
-		*columns,
-		*column_data,
-		MKD_TABLE_HEADER
-	);
-
 	return under_end + 1;
 }
 
@@ -2361,54 +3977,98 @@ parse_table(
 	uint8_t *data,
 	size_t size)
 {
-	size_t i;
+	size_t i, columns, header_size;
+	int streamed;
 
-	struct buf *header_work = 0;
-	struct buf *body_work = 0;
+	struct buf *header_work = ob;
+	struct buf *body_work = ob;
+	struct buf *row_work, *cell_work;
 
-	size_t columns;
-	int *col_data = NULL;
+	i = parse_table_header(rndr, data, size, &columns, &header_size);
+	if (i == 0)
+		return 0;
+
+	/* streamed tables render their rows straight into `ob`;
+	 * otherwise the header and the body are gathered for `table` */
+	streamed = (rndr->cb.table_open && rndr->cb.table_close);
+
+	if (!streamed) {
+		header_work = rndr_newbuf(rndr, BUFFER_SPAN);
+		body_work = rndr_newbuf(rndr, BUFFER_BLOCK);
+	}
 
-	header_work = rndr_newbuf(rndr, BUFFER_SPAN);
-	body_work = rndr_newbuf(rndr, BUFFER_BLOCK);
+	/* one row and one cell buffer, reused for the whole table */
+	row_work = rndr_newbuf(rndr, BUFFER_SPAN);
+	cell_work = rndr_newbuf(rndr, BUFFER_SPAN);
 
-	i = parse_table_header(header_work, rndr, data, size, &columns, &col_data);
-	if (i > 0) {
+	if (streamed)
+		rndr->cb.table_open(ob, MKD_TABLE_HEADER, rndr->opaque);
 
-		while (i < size) {
-			size_t row_start;
-			int pipes = 0;
+	parse_table_row(
+		header_work, rndr, data,
+		header_size,
+		columns,
+		rndr->table_cols,
+		MKD_TABLE_HEADER,
+		row_work, cell_work
+	);
 
-			row_start = i;
+	if (streamed) {
+		rndr->cb.table_close(ob, MKD_TABLE_HEADER, rndr->opaque);
+		rndr->cb.table_open(ob, 0, rndr->opaque);
+	}
 
-			while (i < size && data[i] != '\n')
-				if (data[i++] == '|')
-					pipes++;
+	while (i < size) {
+		size_t row_start, written, text_chars;
+		int pipes = 0;
 
-			if (pipes == 0 || i == size) {
-				i = row_start;
-				break;
-			}
+		row_start = i;
 
-			parse_table_row(
-				body_work,
-				rndr,
-				data + row_start,
-				i - row_start,
-				columns,
-				col_data, 0
-			);
+		while (i < size && data[i] != '\n')
+			if (data[i++] == '|')
+				pipes++;
 
-			i++;
+		if (pipes == 0 || i == size) {
+			i = row_start;
+			break;
 		}
 
-		if (rndr->cb.table)
-			rndr->cb.table(ob, header_work, body_work, rndr->opaque);
+		written = body_work->size;
+		text_chars = rndr->text_chars;
+
+		parse_table_row(
+			body_work,
+			rndr,
+			data + row_start,
+			i - row_start,
+			columns,
+			rndr->table_cols, 0,
+			row_work, cell_work
+		);
+
+		i++;
+
+		/* a row max_text has cut down to nothing is taken back */
+		if (rndr->stopped == MKD_STOP_TEXT && rndr->text_chars == text_chars)
+			body_work->size = written;
+
+		if (rndr->stopped)
+			break;
 	}
 
-	free(col_data);
+	if (streamed)
+		rndr->cb.table_close(ob, 0, rndr->opaque);
+	else if (rndr->cb.table)
+		rndr->cb.table(ob, header_work, body_work, rndr->opaque);
+
 	rndr_popbuf(rndr, BUFFER_SPAN);
-	rndr_popbuf(rndr, BUFFER_BLOCK);
+	rndr_popbuf(rndr, BUFFER_SPAN);
+
+	if (!streamed) {
+		rndr_popbuf(rndr, BUFFER_SPAN);
+		rndr_popbuf(rndr, BUFFER_BLOCK);
+	}
+
 	return i;
 }
 
@@ -2416,29 +4076,39 @@ parse_table(
 static void
 parse_block(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t size)
 {
-	size_t beg, end, i;
+	size_t beg, end, i, written, text_chars;
 	uint8_t *txt_data;
+	struct block_lines lines, *parent_lines;
+	struct line_info *line;
 	beg = 0;
 
 	if (rndr->work_bufs[BUFFER_SPAN].size +
 		rndr->work_bufs[BUFFER_BLOCK].size > rndr->max_nesting)
 		return;
 
-	while (beg < size) {
+	push_block_lines(rndr, &lines, data, size);
+	parent_lines = rndr->lines;
+	rndr->lines = &lines;
+
+	while (beg < size && !budget_spent(rndr, ob, 0)) {
 		txt_data = data + beg;
 		end = size - beg;
+		line = find_line(rndr, txt_data);
+		written = ob->size;
+		text_chars = rndr->text_chars;
+		rndr->text_space = 1;
 
-		if (is_atxheader(rndr, txt_data, end))
+		if (line_may_be(line, LINE_ATXHEADER) && is_atxheader(rndr, txt_data, end))
 			beg += parse_atxheader(ob, rndr, txt_data, end);
 
 		else if (data[beg] == '<' && rndr->cb.blockhtml &&
 				(i = parse_htmlblock(ob, rndr, txt_data, end, 1)) != 0)
 			beg += i;
 
-		else if ((i = is_empty(txt_data, end)) != 0)
+		else if (line_may_be(line, LINE_EMPTY) && (i = is_empty(txt_data, end)) != 0)
 			beg += i;
 
-		else if (is_hrule(txt_data, end)) {
+		else if (line_may_be(line, LINE_HRULE) && is_hrule(txt_data, end)) {
 			if (rndr->cb.hrule)
 				rndr->cb.hrule(ob, rndr->opaque);
 
@@ -2449,6 +4119,7 @@ parse_block(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t size
 		}
 
 		else if ((rndr->ext_flags & MKDEXT_FENCED_CODE) != 0 &&
+			line_may_be(line, LINE_FENCE) &&
 			(i = parse_fencedcode(ob, rndr, txt_data, end)) != 0)
 			beg += i;
 
@@ -2456,21 +4127,32 @@ parse_block(struct buf *ob, struct sd_markdown *rndr, uint8_t *data, size_t size
 			(i = parse_table(ob, rndr, txt_data, end)) != 0)
 			beg += i;
 
-		else if (prefix_quote(txt_data, end))
+		else if (line_may_be(line, LINE_QUOTE) && prefix_quote(txt_data, end))
 			beg += parse_blockquote(ob, rndr, txt_data, end);
 
-		else if (!(rndr->ext_flags & MKDEXT_DISABLE_INDENTED_CODE) && prefix_code(txt_data, end))
+		else if (!(rndr->ext_flags & MKDEXT_DISABLE_INDENTED_CODE) &&
+			line_may_be(line, LINE_CODE) && prefix_code(txt_data, end))
 			beg += parse_blockcode(ob, rndr, txt_data, end);
 
-		else if (prefix_uli(txt_data, end))
+		else if (line_may_be(line, LINE_ULI) && prefix_uli(txt_data, end))
 			beg += parse_list(ob, rndr, txt_data, end, 0);
 
-		else if (prefix_oli(txt_data, end))
+		else if (line_may_be(line, LINE_OLI) && prefix_oli(txt_data, end))
 			beg += parse_list(ob, rndr, txt_data, end, MKD_LIST_ORDERED);
 
 		else
 			beg += parse_paragraph(ob, rndr, txt_data, end);
+
+		/* a block max_text has cut down to nothing is taken back;
+		 * max_blocks counts the ones written out at the top level */
+		if (rndr->stopped == MKD_STOP_TEXT && rndr->text_chars == text_chars)
+			ob->size = written;
+		else if (ob == rndr->out && ob->size > written)
+			rndr->blocks++;
 	}
+
+	rndr->lines = parent_lines;
+	pop_block_lines(rndr, &lines);
 }
 
 
@@ -2571,14 +4253,13 @@ is_footnote(const uint8_t *data, size_t beg, size_t end, size_t *last, struct fo
 
 	if (list) {
 		struct footnote_ref *ref;
-		ref = create_footnote_ref(list, data + id_offset, id_end - id_offset);
-		if (!ref)
-			return 0;
-		if (!add_footnote_ref(list, ref)) {
-			free_footnote_ref(ref);
+		ref = add_footnote_ref(list, data + id_offset, id_end - id_offset);
+		if (!ref) {
+			bufrelease(contents);
 			return 0;
 		}
 		ref->contents = contents;
+		ref->src_offset = beg;
 	}
 
 	return 1;
@@ -2586,7 +4267,7 @@ is_footnote(const uint8_t *data, size_t beg, size_t end, size_t *last, struct fo
 
 /* is_ref • returns whether a line is a reference or not */
 static int
-is_ref(const uint8_t *data, size_t beg, size_t end, size_t *last, struct link_ref **refs)
+is_ref(const uint8_t *data, size_t beg, size_t end, size_t *last, struct link_refs *refs)
 {
 /*	int n; */
 	size_t i = 0;
@@ -2704,10 +4385,10 @@ static void expand_tabs(struct buf *ob, const uint8_t *line, size_t size)
 
 	while (i < size) {
 		size_t org = i;
+		const uint8_t *next = memchr(line + i, '\t', size - i);
 
-		while (i < size && line[i] != '\t') {
-			i++; tab++;
-		}
+		i = next ? (size_t)(next - line) : size;
+		tab += i - org;
 
 		if (i > org)
 			bufput(ob, line + org, i - org);
@@ -2780,14 +4461,47 @@ sd_markdown_new(
 	if (extensions & MKDEXT_SUPERSCRIPT)
 		md->active_char['^'] = MD_CHAR_SUPERSCRIPT;
 
-	if (extensions & MKDEXT_QUOTE)
+	if ((extensions & MKDEXT_QUOTE) && md->cb.quote)
 		md->active_char['"'] = MD_CHAR_QUOTE;
 
+	/* emoji shortcodes share the ':' of autolinks */
+	if ((extensions & MKDEXT_EMOJI) && md->cb.emoji)
+		md->active_char[':'] = MD_CHAR_EMOJI;
+
 	/* Extension data */
 	md->ext_flags = extensions;
 	md->opaque = opaque;
 	md->max_nesting = max_nesting;
 	md->in_link_body = 0;
+	md->span = NULL;
+
+	md->lines = NULL;
+	md->line_pool = NULL;
+	md->line_pool_size = 0;
+	md->line_pool_asize = 0;
+
+	md->table_cols = NULL;
+	md->table_cols_asize = 0;
+
+	memset(md->table_pool, 0x0, sizeof(md->table_pool));
+	memset(md->table_pool_size, 0x0, sizeof(md->table_pool_size));
+	md->live_tables = NULL;
+	md->live_size = 0;
+	md->live_asize = 0;
+
+	md->budget = NULL;
+	md->link_hook = NULL;
+	md->link_hook_opaque = NULL;
+	md->header_hook = NULL;
+	md->mention_url = NULL;
+	md->issue_url = NULL;
+	md->header_hook_opaque = NULL;
+	md->out = NULL;
+	md->stopped = MKD_STOP_NONE;
+
+	md->doc = NULL;
+	memset(&md->refs, 0x0, sizeof(md->refs));
+	memset(&md->footnotes, 0x0, sizeof(md->footnotes));
 
 	return md;
 }
@@ -2799,28 +4513,42 @@ sd_markdown_render(struct buf *ob, const uint8_t *document, size_t doc_size, str
 	static const char UTF8_BOM[] = {0xEF, 0xBB, 0xBF};
 
 	struct buf *text;
-	size_t beg, end;
+	size_t beg, end, i;
 	int in_fence = 0;
 
-	text = bufnew(64);
-	if (!text)
-		return;
+	if (!md->doc) {
+		md->doc = bufnew(64);
+		if (!md->doc)
+			return;
+	}
+
+	text = md->doc;
+	text->size = 0;
+
+	/* tables left over from a render a callback raised out of */
+	release_span_tables(md, 0);
+	md->span = NULL;
+
+	md->out = ob;
+	md->budget_checks = 0;
+	md->triggers = 0;
+	md->text_chars = 0;
+	md->text_space = 1;
+	md->blocks = 0;
+	md->stopped = MKD_STOP_NONE;
+
+	md->src = document;
+	md->src_size = doc_size;
+	md->src_cursor = 0;
+	md->src_col_pos = 0;
+	md->src_col = 0;
 
 	/* Preallocate enough space for our buffer to avoid expanding while copying */
 	bufgrow(text, doc_size);
 
-	/* reset the references table */
-	memset(&md->refs, 0x0, REF_TABLE_SIZE * sizeof(void *));
-
 	int footnotes_enabled  = md->ext_flags & MKDEXT_FOOTNOTES;
 	int codefences_enabled = md->ext_flags & MKDEXT_FENCED_CODE;
 
-	/* reset the footnotes lists */
-	if (footnotes_enabled) {
-		memset(&md->footnotes_found, 0x0, sizeof(md->footnotes_found));
-		memset(&md->footnotes_used, 0x0, sizeof(md->footnotes_used));
-	}
-
 	/* first pass: looking for references, copying everything else */
 	beg = 0;
 
@@ -2833,14 +4561,16 @@ sd_markdown_render(struct buf *ob, const uint8_t *document, size_t doc_size, str
 		if (codefences_enabled && (is_codefence(document + beg, doc_size - beg, NULL) != 0))
 			in_fence = !in_fence;
 
-		if (!in_fence && footnotes_enabled && is_footnote(document, beg, doc_size, &end, &md->footnotes_found))
+		if (!in_fence && footnotes_enabled && is_footnote(document, beg, doc_size, &end, &md->footnotes))
 			beg = end;
-		else if (!in_fence && is_ref(document, beg, doc_size, &end, md->refs))
+		else if (!in_fence && is_ref(document, beg, doc_size, &end, &md->refs))
 			beg = end;
 		else { /* skipping to the next line */
-			end = beg;
-			while (end < doc_size && document[end] != '\n' && document[end] != '\r')
-				end++;
+			const uint8_t *eol = memchr(document + beg, '\n', doc_size - beg);
+
+			end = eol ? (size_t)(eol - document) : doc_size;
+			if ((eol = memchr(document + beg, '\r', end - beg)) != NULL)
+				end = eol - document;
 
 			/* adding the line body if present */
 			if (end > beg)
@@ -2873,20 +4603,30 @@ sd_markdown_render(struct buf *ob, const uint8_t *document, size_t doc_size, str
 	}
 
 	/* footnotes */
-	if (footnotes_enabled)
-		parse_footnote_list(ob, md, &md->footnotes_used);
+	if (footnotes_enabled && !md->stopped)
+		parse_footnote_list(ob, md, &md->footnotes);
 
 	if (md->cb.doc_footer)
 		md->cb.doc_footer(ob, md->opaque);
 
 	/* clean-up */
-	bufrelease(text);
-	free_link_refs(md->refs);
-	if (footnotes_enabled) {
-		free_footnote_list(&md->footnotes_found, 1);
-		free_footnote_list(&md->footnotes_used, 0);
+	if (text->asize > DOC_KEEP_SIZE) {
+		bufrelease(text);
+		md->doc = NULL;
 	}
 
+	free_link_refs(&md->refs);
+	for (i = 0; i < TABLE_KINDS; ++i) {
+		if (md->table_pool_size[i] > TABLE_KEEP_SIZE) {
+			free(md->table_pool[i]);
+			md->table_pool[i] = NULL;
+			md->table_pool_size[i] = 0;
+		}
+	}
+
+	if (footnotes_enabled)
+		reset_footnote_list(&md->footnotes);
+
 	assert(md->work_bufs[BUFFER_SPAN].size == 0);
 	assert(md->work_bufs[BUFFER_BLOCK].size == 0);
 }
@@ -2905,5 +4645,58 @@ sd_markdown_free(struct sd_markdown *md)
 	redcarpet_stack_free(&md->work_bufs[BUFFER_SPAN]);
 	redcarpet_stack_free(&md->work_bufs[BUFFER_BLOCK]);
 
+	bufrelease(md->doc);
+	free_link_refs(&md->refs);
+	free(md->refs.table);
+	release_span_tables(md, 0);
+	free(md->live_tables);
+	for (i = 0; i < TABLE_KINDS; ++i)
+		free(md->table_pool[i]);
+	free(md->line_pool);
+	free(md->table_cols);
+	free_footnote_list(&md->footnotes);
 	free(md);
 }
+
+void
+sd_markdown_set_budget(struct sd_markdown *md, const struct sd_budget *budget)
+{
+	md->budget = budget;
+}
+
+void
+sd_markdown_set_link_hook(struct sd_markdown *md, void (*hook)(const struct sd_link *link, void *opaque), void *opaque)
+{
+	md->link_hook = hook;
+	md->link_hook_opaque = opaque;
+}
+
+void
+sd_markdown_set_header_hook(struct sd_markdown *md, void (*hook)(const struct sd_header *header, void *opaque), void *opaque)
+{
+	md->header_hook = hook;
+	md->header_hook_opaque = opaque;
+}
+
+void
+sd_markdown_set_references(struct sd_markdown *md, const char *mention_url, const char *issue_url)
+{
+	md->mention_url = mention_url;
+	md->issue_url = issue_url;
+
+	/* '@' goes back to addresses, '#' to plain text */
+	if (mention_url && md->cb.link)
+		md->active_char['@'] = MD_CHAR_MENTION;
+	else if (md->ext_flags & MKDEXT_AUTOLINK)
+		md->active_char['@'] = MD_CHAR_AUTOLINK_EMAIL;
+	else
+		md->active_char['@'] = MD_CHAR_NONE;
+
+	md->active_char['#'] = (issue_url && md->cb.link) ? MD_CHAR_ISSUE : MD_CHAR_NONE;
+}
+
+enum mkd_stop
+sd_markdown_stopped(const struct sd_markdown *md)
+{
+	return md->stopped;
+}
@@ -58,7 +58,65 @@ enum mkd_extensions {
 	MKDEXT_DISABLE_INDENTED_CODE = (1 << 9),
 	MKDEXT_HIGHLIGHT = (1 << 10),
 	MKDEXT_FOOTNOTES = (1 << 11),
-	MKDEXT_QUOTE = (1 << 12)
+	MKDEXT_QUOTE = (1 << 12),
+	MKDEXT_EMOJI = (1 << 13)
+};
+
+/* mkd_stop - why a render was cut short */
+enum mkd_stop {
+	MKD_STOP_NONE = 0,
+	MKD_STOP_OUTPUT,	/* the output grew past max_output */
+	MKD_STOP_TRIGGERS,	/* more than max_triggers span triggers were run */
+	MKD_STOP_POLL,		/* the poll callback asked to stop */
+	MKD_STOP_TEXT,		/* max_text characters of text were written */
+	MKD_STOP_BLOCKS		/* max_blocks top-level blocks were written */
+};
+
+/* sd_budget - limits a render is held to, zero meaning no limit */
+/*	they are checked between blocks and before each span trigger; poll is
+ *	called every few of those checks, to look at a clock or for a request
+ *	to cancel, and stops the render by returning non-zero. max_text counts
+ *	the characters of text and code handed to the renderer, and cuts the
+ *	text that goes over it at a word boundary where it can */
+struct sd_budget {
+	size_t max_output;
+	size_t max_triggers;
+	size_t max_text;
+	size_t max_blocks;
+	int (*poll)(void *opaque);
+	void *opaque;
+};
+
+/* mkd_link_kind - how a link was written */
+enum mkd_link_kind {
+	MKD_LINK_INLINE,	/* [text](url "title") */
+	MKD_LINK_REFERENCE,	/* [text][id], [id][] or [id] */
+	MKD_LINK_AUTOLINK,	/* <url>, or a bare URL, address or www. link */
+	MKD_LINK_IMAGE,		/* ![alt](url) or ![alt][id] */
+	MKD_LINK_MENTION,	/* @user */
+	MKD_LINK_ISSUE		/* #123 */
+};
+
+#define SD_NO_OFFSET ((size_t)-1)
+
+/* sd_link - a link or image found by the parser */
+/*	url is unescaped, and title is as written or NULL. offset is where
+ *	the link starts in the rendered document, or SD_NO_OFFSET when it
+ *	can't be traced back there */
+struct sd_link {
+	enum mkd_link_kind kind;
+	const struct buf *url;
+	const struct buf *title;
+	size_t offset;
+};
+
+/* sd_header - a header found by the parser */
+/*	text is its content as rendered by the span callbacks, and offset
+ *	is as in sd_link */
+struct sd_header {
+	int level;
+	const struct buf *text;
+	size_t offset;
 };
 
 /* sd_callbacks - functions for rendering parsed data */
@@ -94,6 +152,7 @@ struct sd_callbacks {
 	int (*strikethrough)(struct buf *ob, const struct buf *text, void *opaque);
 	int (*superscript)(struct buf *ob, const struct buf *text, void *opaque);
 	int (*footnote_ref)(struct buf *ob, unsigned int num, void *opaque);
+	int (*emoji)(struct buf *ob, const struct buf *name, const struct buf *character, void *opaque);
 
 	/* low level callbacks - NULL copies input directly into the output */
 	void (*entity)(struct buf *ob, const struct buf *entity, void *opaque);
@@ -102,6 +161,13 @@ struct sd_callbacks {
 	/* header and footer */
 	void (*doc_header)(struct buf *ob, void *opaque);
 	void (*doc_footer)(struct buf *ob, void *opaque);
+
+	/* streamed tables - when both are set, `table` is not called;
+	 * the header section (flags = MKD_TABLE_HEADER) and then the
+	 * body section (flags = 0) are opened and closed around their
+	 * rows, which are rendered straight into the output */
+	void (*table_open)(struct buf *ob, int flags, void *opaque);
+	void (*table_close)(struct buf *ob, int flags, void *opaque);
 };
 
 struct sd_markdown;
@@ -131,6 +197,30 @@ sd_markdown_render(struct buf *ob, const uint8_t *document, size_t doc_size, str
 extern void
 sd_markdown_free(struct sd_markdown *md);
 
+/* sd_markdown_set_budget - limits the following renders, or lifts the limits when NULL */
+extern void
+sd_markdown_set_budget(struct sd_markdown *md, const struct sd_budget *budget);
+
+/* sd_markdown_set_link_hook - calls hook with every link the following renders find, or stops when NULL */
+/*	links are reported as they are parsed, whether or not the renderer
+ *	accepts them */
+extern void
+sd_markdown_set_link_hook(struct sd_markdown *md, void (*hook)(const struct sd_link *link, void *opaque), void *opaque);
+
+/* sd_markdown_set_header_hook - calls hook with every header the following renders find, or stops when NULL */
+extern void
+sd_markdown_set_header_hook(struct sd_markdown *md, void (*hook)(const struct sd_header *header, void *opaque), void *opaque);
+
+/* sd_markdown_set_references - links @user and #123 in the following renders to the given URLs, or stops when NULL */
+/*	every "%s" of a URL is replaced with the user name or the issue
+ *	number; the URLs are not copied and must outlive the renders */
+extern void
+sd_markdown_set_references(struct sd_markdown *md, const char *mention_url, const char *issue_url);
+
+/* sd_markdown_stopped - why the last render stopped early, MKD_STOP_NONE when it didn't */
+extern enum mkd_stop
+sd_markdown_stopped(const struct sd_markdown *md);
+
 #ifdef __cplusplus
 }
 #endif
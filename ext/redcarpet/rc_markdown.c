@@ -14,12 +14,53 @@
  * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 #include "redcarpet.h"
+#include <time.h>
 
 VALUE rb_mRedcarpet;
 VALUE rb_cMarkdown;
 
 extern VALUE rb_cRenderBase;
 
+/* the output of a render is written straight into the Ruby String
+ * that is returned; its length is kept in sync so that growing it
+ * never loses what was written */
+static int rb_redcarpet_outbuf_grow(struct buf *ob, size_t neoasz)
+{
+	VALUE str = (VALUE)ob->store;
+
+	/* the buffer unit suits small work buffers; grow geometrically */
+	if (neoasz < ob->asize * 2)
+		neoasz = ob->asize * 2;
+
+	rb_str_set_len(str, ob->size);
+	rb_str_modify_expand(str, neoasz - ob->size);
+
+	ob->data = (uint8_t *)RSTRING_PTR(str);
+	ob->asize = rb_str_capacity(str);
+	return BUF_OK;
+}
+
+VALUE rb_redcarpet_outbuf_new(struct buf *ob, size_t capa)
+{
+	VALUE str = rb_str_buf_new(capa);
+
+	bufinit_store(ob, 128, rb_redcarpet_outbuf_grow, (void *)str);
+	ob->data = (uint8_t *)RSTRING_PTR(str);
+	ob->asize = rb_str_capacity(str);
+	return str;
+}
+
+VALUE rb_redcarpet_outbuf_finish(struct buf *ob, rb_encoding *enc)
+{
+	VALUE str = (VALUE)ob->store;
+
+	/* resizing only keeps what is within the current length */
+	rb_str_set_len(str, ob->size);
+	rb_str_resize(str, ob->size);
+	rb_enc_associate(str, enc);
+	return str;
+}
+
 static void rb_redcarpet_md_flags(VALUE hash, unsigned int *enabled_extensions_p)
 {
 	unsigned int extensions = 0;
@@ -56,6 +97,9 @@ static void rb_redcarpet_md_flags(VALUE hash, unsigned int *enabled_extensions_p
 	if (rb_hash_lookup(hash, CSTR2SYM("quote")) == Qtrue)
 		extensions |= MKDEXT_QUOTE;
 
+	if (rb_hash_lookup(hash, CSTR2SYM("emoji")) == Qtrue)
+		extensions |= MKDEXT_EMOJI;
+
 	if (rb_hash_lookup(hash, CSTR2SYM("lax_spacing")) == Qtrue)
 		extensions |= MKDEXT_LAX_SPACING;
 
@@ -71,10 +115,267 @@ static void rb_redcarpet_md_flags(VALUE hash, unsigned int *enabled_extensions_p
 	*enabled_extensions_p = extensions;
 }
 
+/* the URL template of `:mentions` or `:issues`, copied, or NULL */
+static char *
+rb_redcarpet_md_url(VALUE hash, const char *name)
+{
+	VALUE url = rb_hash_lookup(hash, CSTR2SYM(name));
+	const char *template;
+	size_t size;
+	char *copy;
+
+	if (!RTEST(url))
+		return NULL;
+
+	template = StringValueCStr(url);
+	size = strlen(template) + 1;
+	copy = xmalloc(size);
+	memcpy(copy, template, size);
+	return copy;
+}
+
+/* a render context: a parser along with its own copy of the renderer
+ * options, which hold per-render state (the active encoding, the TOC
+ * nesting). A Markdown instance keeps the idle ones in a small pool so
+ * that renders running at the same time (from other threads, or from a
+ * renderer callback) each get one of their own */
+enum rb_redcarpet_md_kind {
+	MD_RENDER,	/* the renderer's callbacks */
+	MD_COUNT,	/* `sdstats_renderer`, for `stats` and `extract_links` */
+	MD_OUTLINE,	/* `sdhtml_outline_renderer`, for `headings` */
+	MD_KINDS
+};
+
+struct rb_redcarpet_md_ctx {
+	struct sd_markdown *markdown;
+	struct redcarpet_renderopt options;
+	struct sd_stats stats;
+	struct buf *scratch;
+	struct rb_redcarpet_md_ctx *next;
+	enum rb_redcarpet_md_kind kind;
+	int busy;
+};
+
+struct rb_redcarpet_md {
+	struct rb_redcarpet_rndr *rndr;
+	unsigned int extensions;
+	char *mention_url;
+	char *issue_url;
+	struct rb_redcarpet_md_ctx *idle[MD_KINDS];
+};
+
+struct rb_redcarpet_md_call {
+	struct rb_redcarpet_md *md;
+	struct rb_redcarpet_md_ctx *ctx;
+	struct buf *ob;
+	VALUE text;
+	VALUE targets;		/* links handed to `resolve_links`, */
+	VALUE resolved;		/* and what it returned */
+	struct sd_budget budget;
+	double deadline;
+	enum mkd_stop stopped;
+};
+
+static double
+rb_redcarpet_md_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* polled every few steps of a render: lets other threads run, and
+ * Thread#raise or Timeout interrupt it, besides checking the deadline */
+static int
+rb_redcarpet_md_poll(void *opaque)
+{
+	struct rb_redcarpet_md_call *call = opaque;
+
+	rb_thread_check_ints();
+
+	return call->deadline > 0 && rb_redcarpet_md_now() > call->deadline;
+}
+
+static void
+rb_redcarpet_md_budget(VALUE hash, struct rb_redcarpet_md_call *call)
+{
+	VALUE limit;
+
+	Check_Type(hash, T_HASH);
+
+	limit = rb_hash_lookup(hash, CSTR2SYM("timeout"));
+	if (!NIL_P(limit))
+		call->deadline = rb_redcarpet_md_now() + NUM2DBL(limit);
+
+	limit = rb_hash_lookup(hash, CSTR2SYM("max_output"));
+	if (!NIL_P(limit))
+		call->budget.max_output = NUM2SIZET(limit);
+
+	limit = rb_hash_lookup(hash, CSTR2SYM("max_triggers"));
+	if (!NIL_P(limit))
+		call->budget.max_triggers = NUM2SIZET(limit);
+}
+
+static void
+rb_redcarpet_md_stopped(enum mkd_stop stopped, VALUE partial)
+{
+	const char *reason;
+	VALUE error;
+
+	switch (stopped) {
+	case MKD_STOP_OUTPUT:
+		reason = "max_output";
+		break;
+	case MKD_STOP_TRIGGERS:
+		reason = "max_triggers";
+		break;
+	default:
+		reason = "timeout";
+		break;
+	}
+
+	error = rb_const_get(rb_mRedcarpet, rb_intern("RenderLimitExceeded"));
+	rb_exc_raise(rb_funcall(error, rb_intern("new"), 2, CSTR2SYM(reason), partial));
+}
+
+/* only the render contexts use the renderer's callbacks; the others
+ * parse with callbacks of their own, for the methods that don't render */
+static struct rb_redcarpet_md_ctx *
+rb_redcarpet_md_ctx_new(struct rb_redcarpet_md *md, enum rb_redcarpet_md_kind kind)
+{
+	struct rb_redcarpet_md_ctx *ctx = ALLOC(struct rb_redcarpet_md_ctx);
+	struct sd_callbacks callbacks;
+
+	ctx->scratch = NULL;
+
+	switch (kind) {
+	case MD_COUNT:
+		sdstats_renderer(&callbacks);
+		ctx->markdown = sd_markdown_new(md->extensions, 16, &callbacks, &ctx->stats);
+		break;
+	case MD_OUTLINE:
+		sdhtml_outline_renderer(&callbacks, &ctx->options.html);
+		ctx->markdown = sd_markdown_new(md->extensions, 16, &callbacks, &ctx->options.html);
+		ctx->scratch = bufnew(64);
+		break;
+	default:
+		ctx->markdown = sd_markdown_new(md->extensions, 16, &md->rndr->callbacks, &ctx->options);
+		break;
+	}
+
+	if (!ctx->markdown || (kind == MD_OUTLINE && !ctx->scratch)) {
+		if (ctx->markdown)
+			sd_markdown_free(ctx->markdown);
+		bufrelease(ctx->scratch);
+		xfree(ctx);
+		rb_raise(rb_eRuntimeError, "Failed to create new Renderer class");
+	}
+
+	/* every kind links references, so that `extract_links` and
+	 * `resolve_links` see them too */
+	sd_markdown_set_references(ctx->markdown, md->mention_url, md->issue_url);
+
+	ctx->next = NULL;
+	ctx->kind = kind;
+	ctx->busy = 0;
+	return ctx;
+}
+
+static void
+rb_redcarpet_md_ctx_free(struct rb_redcarpet_md_ctx *ctx)
+{
+	sd_markdown_free(ctx->markdown);
+	bufrelease(ctx->scratch);
+	xfree(ctx);
+}
+
+static struct rb_redcarpet_md_ctx *
+rb_redcarpet_md_acquire(struct rb_redcarpet_md *md, enum rb_redcarpet_md_kind kind)
+{
+	struct rb_redcarpet_md_ctx **idle = &md->idle[kind];
+	struct rb_redcarpet_md_ctx *ctx = *idle;
+
+	if (ctx)
+		*idle = ctx->next;
+	else
+		ctx = rb_redcarpet_md_ctx_new(md, kind);
+
+	/* the renderer options are fixed once it is built; take a fresh
+	 * copy so nothing is left over from an earlier render */
+	if (kind == MD_COUNT)
+		memset(&ctx->stats, 0x0, sizeof(ctx->stats));
+	else if (kind == MD_RENDER)
+		ctx->options = md->rndr->options;
+
+	ctx->busy = 1;
+	return ctx;
+}
+
+static VALUE
+rb_redcarpet_md_release(VALUE arg)
+{
+	struct rb_redcarpet_md_call *call = (struct rb_redcarpet_md_call *)arg;
+	struct rb_redcarpet_md_ctx *ctx = call->ctx;
+	struct rb_redcarpet_md_ctx **idle;
+
+	if (ctx->kind == MD_RENDER) {
+		rb_redcarpet_link_map_free(ctx->options.link_map);
+		ctx->options.link_map = NULL;
+	}
+
+	/* a render cut short by a raising callback leaves the parser
+	 * half-way through the document; don't hand it out again */
+	if (ctx->busy) {
+		rb_redcarpet_md_ctx_free(ctx);
+		return Qnil;
+	}
+
+	idle = &call->md->idle[ctx->kind];
+	ctx->next = *idle;
+	*idle = ctx;
+	return Qnil;
+}
+
+static VALUE
+rb_redcarpet_md_run(VALUE arg)
+{
+	struct rb_redcarpet_md_call *call = (struct rb_redcarpet_md_call *)arg;
+
+	/* built once the context holds it, so that its release frees it */
+	if (RTEST(call->resolved))
+		call->ctx->options.link_map = rb_redcarpet_link_map_new(call->targets, call->resolved);
+
+	sd_markdown_set_budget(call->ctx->markdown, &call->budget);
+	sd_markdown_render(
+		call->ob,
+		(const uint8_t*)RSTRING_PTR(call->text),
+		RSTRING_LEN(call->text),
+		call->ctx->markdown);
+
+	call->stopped = sd_markdown_stopped(call->ctx->markdown);
+	sd_markdown_set_budget(call->ctx->markdown, NULL);
+	call->ctx->busy = 0;
+	return Qnil;
+}
+
 static void
-rb_redcarpet_md__free(void *markdown)
+rb_redcarpet_md__free(void *data)
 {
-	sd_markdown_free((struct sd_markdown *)markdown);
+	struct rb_redcarpet_md *md = data;
+	struct rb_redcarpet_md_ctx *ctx, *next;
+	int kind;
+
+	for (kind = 0; kind < MD_KINDS; ++kind) {
+		for (ctx = md->idle[kind]; ctx; ctx = next) {
+			next = ctx->next;
+			rb_redcarpet_md_ctx_free(ctx);
+		}
+	}
+
+	xfree(md->mention_url);
+	xfree(md->issue_url);
+	xfree(md);
 }
 
 static VALUE rb_redcarpet_md__new(int argc, VALUE *argv, VALUE klass)
@@ -83,7 +384,7 @@ static VALUE rb_redcarpet_md__new(int argc, VALUE *argv, VALUE klass)
 	unsigned int extensions = 0;
 
 	struct rb_redcarpet_rndr *rndr;
-	struct sd_markdown *markdown;
+	struct rb_redcarpet_md *md;
 
 	if (rb_scan_args(argc, argv, "11", &rb_rndr, &hash) == 2)
 		rb_redcarpet_md_flags(hash, &extensions);
@@ -96,50 +397,218 @@ static VALUE rb_redcarpet_md__new(int argc, VALUE *argv, VALUE klass)
 
 	Data_Get_Struct(rb_rndr, struct rb_redcarpet_rndr, rndr);
 
-	markdown = sd_markdown_new(extensions, 16, &rndr->callbacks, &rndr->options);
-	if (!markdown)
-		rb_raise(rb_eRuntimeError, "Failed to create new Renderer class");
+	rb_markdown = Data_Make_Struct(klass, struct rb_redcarpet_md, NULL, rb_redcarpet_md__free, md);
+	md->rndr = rndr;
+	md->extensions = extensions;
+
+	if (!NIL_P(hash)) {
+		md->mention_url = rb_redcarpet_md_url(hash, "mentions");
+		md->issue_url = rb_redcarpet_md_url(hash, "issues");
+	}
+
+	/* most instances only ever render from one place at a time */
+	memset(md->idle, 0x0, sizeof(md->idle));
+	md->idle[MD_RENDER] = rb_redcarpet_md_ctx_new(md, MD_RENDER);
 
-	rb_markdown = Data_Wrap_Struct(klass, NULL, rb_redcarpet_md__free, markdown);
 	rb_iv_set(rb_markdown, "@renderer", rb_rndr);
 
 	return rb_markdown;
 }
 
-static VALUE rb_redcarpet_md_render(VALUE self, VALUE text)
+static void
+rb_redcarpet_md_call_init(struct rb_redcarpet_md_call *call)
 {
-	VALUE rb_rndr;
-	struct buf *output_buf;
-	struct sd_markdown *markdown;
+	memset(call, 0x0, sizeof(*call));
+	call->budget.poll = rb_redcarpet_md_poll;
+	call->budget.opaque = call;
+}
+
+/* counting renders write nothing out; their output never gets any room */
+static int
+rb_redcarpet_md_nowhere(struct buf *ob, size_t size)
+{
+	return BUF_ENOMEM;
+}
+
+/* what the hooks of `extract_links`, `headings` and `resolve_links` collect */
+struct rb_redcarpet_md_found {
+	VALUE result;
+	rb_encoding *enc;
+	struct buf *scratch;
+	VALUE seen;
+};
+
+static VALUE
+rb_redcarpet_md_found_str(const struct buf *b, rb_encoding *enc)
+{
+	return b ? rb_enc_str_new((const char *)b->data, b->size, enc) : Qnil;
+}
+
+static void
+rb_redcarpet_md_link_found(const struct sd_link *link, void *opaque)
+{
+	static const char *kinds[] = { "inline", "reference", "autolink", "image", "mention", "issue" };
+	struct rb_redcarpet_md_found *links = opaque;
+	VALUE entry = rb_hash_new();
+
+	rb_hash_aset(entry, CSTR2SYM("url"), rb_redcarpet_md_found_str(link->url, links->enc));
+	rb_hash_aset(entry, CSTR2SYM("title"), rb_redcarpet_md_found_str(link->title, links->enc));
+	rb_hash_aset(entry, CSTR2SYM("kind"), CSTR2SYM(kinds[link->kind]));
+	rb_hash_aset(entry, CSTR2SYM("offset"),
+		link->offset == SD_NO_OFFSET ? Qnil : SIZET2NUM(link->offset));
+
+	rb_ary_push(links->result, entry);
+}
+
+/* the targets of the links (not the images) of a text, each once */
+static void
+rb_redcarpet_md_link_target(const struct sd_link *link, void *opaque)
+{
+	struct rb_redcarpet_md_found *targets = opaque;
+	VALUE url;
+
+	if (link->kind == MKD_LINK_IMAGE || !link->url)
+		return;
+
+	url = rb_redcarpet_md_found_str(link->url, targets->enc);
+	if (NIL_P(rb_hash_lookup(targets->seen, url))) {
+		rb_hash_aset(targets->seen, url, Qtrue);
+		rb_ary_push(targets->result, url);
+	}
+}
+
+/* a counting render finds the links of a text without writing anything;
+ * the hook goes with the context if a raise throws it away */
+static void
+rb_redcarpet_md_find_links(struct rb_redcarpet_md *md, VALUE text,
+	void (*hook)(const struct sd_link *link, void *opaque), struct rb_redcarpet_md_found *found)
+{
+	struct buf nowhere = { NULL, 0, 0, 64, rb_redcarpet_md_nowhere, NULL };
+	struct rb_redcarpet_md_call call;
+
+	rb_redcarpet_md_call_init(&call);
+	call.md = md;
+	call.ctx = rb_redcarpet_md_acquire(md, MD_COUNT);
+	call.ob = &nowhere;
+	call.text = rb_str_new_frozen(text);
+
+	sd_markdown_set_link_hook(call.ctx->markdown, hook, found);
+	rb_ensure(rb_redcarpet_md_run, (VALUE)&call, rb_redcarpet_md_release, (VALUE)&call);
+	RB_GC_GUARD(call.text);
+
+	/* back in the pool, the context may next be taken by `stats` */
+	sd_markdown_set_link_hook(call.ctx->markdown, NULL, NULL);
+}
+
+/* puts the HTML `block_code_batch` returned for each code block in
+ * place of its placeholder, or drops them all when it's nil */
+static VALUE
+rb_redcarpet_md_splice_code(VALUE output, VALUE html)
+{
+	const char *data = RSTRING_PTR(output), *end = data + RSTRING_LEN(output);
+	const char *mark, *num;
+	VALUE spliced, block;
+	long n;
+
+	spliced = rb_str_buf_new(RSTRING_LEN(output));
+	rb_enc_copy(spliced, output);
+
+	while ((mark = memchr(data, REDCARPET_CODE_MARK, end - data)) != NULL) {
+		rb_str_buf_cat(spliced, data, mark - data);
+
+		for (num = mark + 1, n = 0; num < end && *num >= '0' && *num <= '9'; num++)
+			n = n * 10 + (*num - '0');
+
+		if (num == mark + 1 || num >= end || *num != REDCARPET_CODE_MARK) {
+			rb_str_buf_cat(spliced, mark, 1);
+			data = mark + 1;
+			continue;
+		}
+
+		if (!NIL_P(html) && !NIL_P(block = rb_ary_entry(html, n))) {
+			Check_Type(block, T_STRING);
+			rb_str_buf_append(spliced, block);
+		}
+
+		data = num + 1;
+	}
+
+	rb_str_buf_cat(spliced, data, end - data);
+	return spliced;
+}
+
+static VALUE
+rb_redcarpet_md__render(VALUE self, VALUE text, struct rb_redcarpet_md_call *call)
+{
+	VALUE rb_rndr, result, code_blocks = Qnil, html, resolved = Qnil;
+	struct rb_redcarpet_md_found targets;
+	struct buf output_buf;
 
 	Check_Type(text, T_STRING);
 
 	rb_rndr = rb_iv_get(self, "@renderer");
-	Data_Get_Struct(self, struct sd_markdown, markdown);
+	Data_Get_Struct(self, struct rb_redcarpet_md, call->md);
 
 	if (rb_respond_to(rb_rndr, rb_intern("preprocess")))
 		text = rb_funcall(rb_rndr, rb_intern("preprocess"), 1, text);
 	if (NIL_P(text))
 		return Qnil;
 
-	struct rb_redcarpet_rndr *renderer;
-	Data_Get_Struct(rb_rndr, struct rb_redcarpet_rndr, renderer);
-	renderer->options.active_enc = rb_enc_get(text);
+	/* `resolve_links` gets every link target at once, before the render */
+	if (call->md->rndr->options.resolved_link || call->md->rndr->options.resolved_autolink) {
+		targets.result = rb_ary_new();
+		targets.enc = rb_enc_get(text);
+		targets.seen = rb_hash_new();
 
-	/* initialize buffers */
-	output_buf = bufnew(128);
+		rb_redcarpet_md_find_links(call->md, text, rb_redcarpet_md_link_target, &targets);
+		if (RARRAY_LEN(targets.result))
+			resolved = rb_funcall(rb_rndr, rb_intern("resolve_links"), 1, targets.result);
+	}
 
-	/* render the magic */
-	sd_markdown_render(
-		output_buf,
-		(const uint8_t*)RSTRING_PTR(text),
-		RSTRING_LEN(text),
-		markdown);
+	/* the output is rendered right into the returned string */
+	result = rb_redcarpet_outbuf_new(&output_buf, RSTRING_LEN(text) + RSTRING_LEN(text) / 2);
+
+	if (!NIL_P(resolved)) {
+		call->targets = targets.result;
+		call->resolved = resolved;
+	}
 
-	/* build the Ruby string */
-	text = rb_enc_str_new((const char*)output_buf->data, output_buf->size, rb_enc_get(text));
+	if (call->md->rndr->options.code_batch &&
+		!memchr(RSTRING_PTR(text), REDCARPET_CODE_MARK, RSTRING_LEN(text)))
+		code_blocks = rb_ary_new();
 
-	bufrelease(output_buf);
+	/* other threads get to run while rendering; make sure they
+	 * can't change the text from under us */
+	call->text = rb_str_new_frozen(text);
+
+	/* nothing may raise from here until the render is under rb_ensure */
+	call->ctx = rb_redcarpet_md_acquire(call->md, MD_RENDER);
+	call->ctx->options.active_enc = rb_enc_get(text);
+	call->ctx->options.code_blocks = code_blocks;
+	call->ob = &output_buf;
+
+	/* render the magic */
+	rb_ensure(rb_redcarpet_md_run, (VALUE)call, rb_redcarpet_md_release, (VALUE)call);
+
+	text = rb_redcarpet_outbuf_finish(&output_buf, rb_enc_get(text));
+	RB_GC_GUARD(result);
+	RB_GC_GUARD(call->text);
+	RB_GC_GUARD(resolved);
+
+	/* an excerpt is supposed to stop early */
+	if (call->stopped != MKD_STOP_NONE &&
+		call->stopped != MKD_STOP_TEXT && call->stopped != MKD_STOP_BLOCKS) {
+		if (!NIL_P(code_blocks) && RARRAY_LEN(code_blocks))
+			text = rb_redcarpet_md_splice_code(text, Qnil);
+		rb_redcarpet_md_stopped(call->stopped, text);
+	}
+
+	if (!NIL_P(code_blocks) && RARRAY_LEN(code_blocks)) {
+		html = rb_funcall(rb_rndr, rb_intern("block_code_batch"), 1, code_blocks);
+		Check_Type(html, T_ARRAY);
+		text = rb_redcarpet_md_splice_code(text, html);
+	}
+	RB_GC_GUARD(code_blocks);
 
 	if (rb_respond_to(rb_rndr, rb_intern("postprocess")))
 		text = rb_funcall(rb_rndr, rb_intern("postprocess"), 1, text);
@@ -147,14 +616,173 @@ static VALUE rb_redcarpet_md_render(VALUE self, VALUE text)
 	return text;
 }
 
+static VALUE rb_redcarpet_md_render(int argc, VALUE *argv, VALUE self)
+{
+	VALUE text, limits;
+	struct rb_redcarpet_md_call call;
+
+	rb_redcarpet_md_call_init(&call);
+
+	if (rb_scan_args(argc, argv, "11", &text, &limits) == 2)
+		rb_redcarpet_md_budget(limits, &call);
+
+	return rb_redcarpet_md__render(self, text, &call);
+}
+
+static VALUE rb_redcarpet_md_excerpt(int argc, VALUE *argv, VALUE self)
+{
+	VALUE text, opts, limit;
+	struct rb_redcarpet_md_call call;
+
+	rb_redcarpet_md_call_init(&call);
+
+	if (rb_scan_args(argc, argv, "11", &text, &opts) == 2) {
+		rb_redcarpet_md_budget(opts, &call);
+
+		limit = rb_hash_lookup(opts, CSTR2SYM("length"));
+		if (!NIL_P(limit) && (call.budget.max_text = NUM2SIZET(limit)) == 0)
+			rb_raise(rb_eArgError, "excerpt length must be positive");
+
+		limit = rb_hash_lookup(opts, CSTR2SYM("blocks"));
+		if (!NIL_P(limit) && (call.budget.max_blocks = NUM2SIZET(limit)) == 0)
+			rb_raise(rb_eArgError, "excerpt blocks must be positive");
+	}
+
+	return rb_redcarpet_md__render(self, text, &call);
+}
+
+#define STAT(name, field) \
+	rb_hash_aset(result, CSTR2SYM(name), SIZET2NUM(stats.field))
+
+static VALUE rb_redcarpet_md_stats(VALUE self, VALUE text)
+{
+	VALUE result;
+	struct buf nowhere = { NULL, 0, 0, 64, rb_redcarpet_md_nowhere, NULL };
+	struct rb_redcarpet_md_call call;
+	struct sd_stats stats;
+
+	Check_Type(text, T_STRING);
+
+	rb_redcarpet_md_call_init(&call);
+	Data_Get_Struct(self, struct rb_redcarpet_md, call.md);
+
+	call.ctx = rb_redcarpet_md_acquire(call.md, MD_COUNT);
+	call.ob = &nowhere;
+	call.text = rb_str_new_frozen(text);
+
+	rb_ensure(rb_redcarpet_md_run, (VALUE)&call, rb_redcarpet_md_release, (VALUE)&call);
+	RB_GC_GUARD(call.text);
+
+	/* the context is back in the pool; read the counts before
+	 * anything else can run and take it */
+	stats = call.ctx->stats;
+
+	result = rb_hash_new();
+	STAT("words", words);
+	STAT("characters", chars);
+	STAT("headers", headers);
+	STAT("paragraphs", paragraphs);
+	STAT("lists", lists);
+	STAT("list_items", list_items);
+	STAT("blockquotes", blockquotes);
+	STAT("code_blocks", code_blocks);
+	STAT("code_lines", code_lines);
+	STAT("tables", tables);
+	STAT("hrules", hrules);
+	STAT("html_blocks", html_blocks);
+	STAT("footnotes", footnotes);
+	STAT("links", links);
+	STAT("images", images);
+
+	return result;
+}
+
+#undef STAT
+
+static VALUE rb_redcarpet_md_extract_links(VALUE self, VALUE text)
+{
+	struct rb_redcarpet_md *md;
+	struct rb_redcarpet_md_found links;
+
+	Check_Type(text, T_STRING);
+	Data_Get_Struct(self, struct rb_redcarpet_md, md);
+
+	links.result = rb_ary_new();
+	links.enc = rb_enc_get(text);
+
+	rb_redcarpet_md_find_links(md, text, rb_redcarpet_md_link_found, &links);
+	return links.result;
+}
+
+static void
+rb_redcarpet_md_header_found(const struct sd_header *header, void *opaque)
+{
+	struct rb_redcarpet_md_found *headers = opaque;
+	struct buf *scratch = headers->scratch;
+	VALUE entry = rb_hash_new();
+
+	rb_hash_aset(entry, CSTR2SYM("level"), INT2FIX(header->level));
+
+	scratch->size = 0;
+	sdhtml_header_text(scratch, header->text);
+	rb_hash_aset(entry, CSTR2SYM("text"), rb_redcarpet_md_found_str(scratch, headers->enc));
+
+	scratch->size = 0;
+	header_anchor(scratch, header->text);
+	rb_hash_aset(entry, CSTR2SYM("anchor"), rb_redcarpet_md_found_str(scratch, headers->enc));
+
+	rb_hash_aset(entry, CSTR2SYM("offset"),
+		header->offset == SD_NO_OFFSET ? Qnil : SIZET2NUM(header->offset));
+
+	rb_ary_push(headers->result, entry);
+}
+
+static VALUE rb_redcarpet_md_headings(VALUE self, VALUE text)
+{
+	struct buf nowhere = { NULL, 0, 0, 64, rb_redcarpet_md_nowhere, NULL };
+	struct rb_redcarpet_md_call call;
+	struct rb_redcarpet_md_found headers;
+
+	Check_Type(text, T_STRING);
+
+	rb_redcarpet_md_call_init(&call);
+	Data_Get_Struct(self, struct rb_redcarpet_md, call.md);
+
+	/* the outline callbacks render the text of the headers as the TOC
+	 * does, and nothing is written out */
+	call.ctx = rb_redcarpet_md_acquire(call.md, MD_OUTLINE);
+	call.ob = &nowhere;
+	call.text = rb_str_new_frozen(text);
+
+	headers.result = rb_ary_new();
+	headers.enc = rb_enc_get(text);
+	headers.scratch = call.ctx->scratch;
+
+	sd_markdown_set_header_hook(call.ctx->markdown, rb_redcarpet_md_header_found, &headers);
+	rb_ensure(rb_redcarpet_md_run, (VALUE)&call, rb_redcarpet_md_release, (VALUE)&call);
+	RB_GC_GUARD(call.text);
+
+	sd_markdown_set_header_hook(call.ctx->markdown, NULL, NULL);
+
+	return headers.result;
+}
+
 __attribute__((visibility("default")))
 void Init_redcarpet()
 {
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+	rb_ext_ractor_safe(true);
+#endif
+
 	rb_mRedcarpet = rb_define_module("Redcarpet");
 
 	rb_cMarkdown = rb_define_class_under(rb_mRedcarpet, "Markdown", rb_cObject);
 	rb_define_singleton_method(rb_cMarkdown, "new", rb_redcarpet_md__new, -1);
-	rb_define_method(rb_cMarkdown, "render", rb_redcarpet_md_render, 1);
+	rb_define_method(rb_cMarkdown, "render", rb_redcarpet_md_render, -1);
+	rb_define_method(rb_cMarkdown, "excerpt", rb_redcarpet_md_excerpt, -1);
+	rb_define_method(rb_cMarkdown, "stats", rb_redcarpet_md_stats, 1);
+	rb_define_method(rb_cMarkdown, "extract_links", rb_redcarpet_md_extract_links, 1);
+	rb_define_method(rb_cMarkdown, "headings", rb_redcarpet_md_headings, 1);
 
 	Init_redcarpet_rndr();
 }
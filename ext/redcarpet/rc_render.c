@@ -15,6 +15,8 @@
  */
 
 #include "redcarpet.h"
+#include "houdini.h"
+#include <ctype.h>
 
 #define SPAN_CALLBACK(method_name, ...) {\
 	struct redcarpet_renderopt *opt = opaque;\
@@ -38,6 +40,8 @@ VALUE rb_mRender;
 VALUE rb_cRenderBase;
 VALUE rb_cRenderHTML;
 VALUE rb_cRenderHTML_TOC;
+VALUE rb_cRenderStripDown;
+VALUE rb_cRenderManPage;
 VALUE rb_mSmartyPants;
 
 #define buf2str(t) ((t) ? rb_enc_str_new((const char*)(t)->data, (t)->size, opt->active_enc) : Qnil)
@@ -48,6 +52,31 @@ rndr_blockcode(struct buf *ob, const struct buf *text, const struct buf *lang, v
 	BLOCK_CALLBACK("block_code", 2, buf2str(text), buf2str(lang));
 }
 
+/* with a `block_code_batch`, the code blocks of a render are collected
+ * for a single call once it is done, a placeholder standing in for each
+ * of them until then; a text holding the mark gets one call per block */
+static void
+rndr_blockcode_batch(struct buf *ob, const struct buf *text, const struct buf *lang, void *opaque)
+{
+	struct redcarpet_renderopt *opt = opaque;
+	VALUE block = rb_ary_new3(2, buf2str(text), buf2str(lang));
+	VALUE ret;
+
+	if (NIL_P(opt->code_blocks)) {
+		ret = rb_funcall(opt->self, rb_intern("block_code_batch"), 1, rb_ary_new3(1, block));
+		Check_Type(ret, T_ARRAY);
+
+		ret = rb_ary_entry(ret, 0);
+		if (NIL_P(ret)) return;
+		Check_Type(ret, T_STRING);
+		bufput(ob, RSTRING_PTR(ret), RSTRING_LEN(ret));
+		return;
+	}
+
+	bufprintf(ob, "%c%ld%c", REDCARPET_CODE_MARK, RARRAY_LEN(opt->code_blocks), REDCARPET_CODE_MARK);
+	rb_ary_push(opt->code_blocks, block);
+}
+
 static void
 rndr_blockquote(struct buf *ob, const struct buf *text, void *opaque)
 {
@@ -237,6 +266,12 @@ rndr_footnote_ref(struct buf *ob, unsigned int num, void *opaque)
 	SPAN_CALLBACK("footnote_ref", 1, INT2FIX(num));
 }
 
+static int
+rndr_emoji(struct buf *ob, const struct buf *name, const struct buf *character, void *opaque)
+{
+	SPAN_CALLBACK("emoji", 2, buf2str(name), buf2str(character));
+}
+
 /**
  * direct writes
  */
@@ -270,19 +305,451 @@ cb_link_attribute(VALUE key, VALUE val, VALUE payload)
 	struct buf *ob = (struct buf *)payload;
 	key = rb_obj_as_string(key);
 	val = rb_obj_as_string(val);
-	bufprintf(ob, " %s=\"%s\"", StringValueCStr(key), StringValueCStr(val));
+	bufputc(ob, ' ');
+	houdini_escape_html0(ob, (const uint8_t *)RSTRING_PTR(key), RSTRING_LEN(key), 0);
+	BUFPUTSL(ob, "=\"");
+	houdini_escape_html0(ob, (const uint8_t *)RSTRING_PTR(val), RSTRING_LEN(val), 0);
+	bufputc(ob, '"');
+	return 0;
+}
+
+/* the attributes are the same for every link; they are written out
+ * once, when the renderer is built, and copied as they are after that */
+static VALUE
+rb_redcarpet_link_attributes(VALUE hash)
+{
+	struct buf ob;
+	VALUE attributes;
+
+	Check_Type(hash, T_HASH);
+
+	attributes = rb_redcarpet_outbuf_new(&ob, 64);
+	rb_hash_foreach(hash, &cb_link_attribute, (VALUE)&ob);
+	attributes = rb_redcarpet_outbuf_finish(&ob, rb_utf8_encoding());
+
+	return rb_obj_freeze(attributes);
+}
+
+/* the URL rules of `Render::HTML`, all in one block with the bytes
+ * they point to */
+struct redcarpet_url_rule {
+	const uint8_t *from;
+	size_t from_size;
+	const uint8_t *to;
+	size_t to_size;
+};
+
+struct redcarpet_url_rules {
+	struct redcarpet_url_rule base_url;
+	struct redcarpet_url_rule external_attributes;
+	size_t host_count;
+	struct redcarpet_url_rule *hosts;
+	size_t image_count;
+	struct redcarpet_url_rule *images;
+};
+
+/* length of the `scheme:` a URL starts with, if any */
+static size_t
+url_scheme(const uint8_t *data, size_t size)
+{
+	size_t i;
+
+	if (!size || !isalpha(data[0]))
+		return 0;
+
+	for (i = 1; i < size; ++i) {
+		if (data[i] == ':')
+			return i + 1;
+		if (!isalnum(data[i]) && data[i] != '+' && data[i] != '-' && data[i] != '.')
+			return 0;
+	}
+
 	return 0;
 }
 
+/* relative URLs have no scheme nor host and aren't a fragment */
+static int
+url_is_relative(const uint8_t *data, size_t size)
+{
+	if (!size || data[0] == '#' || url_scheme(data, size))
+		return 0;
+
+	return size < 2 || data[0] != '/' || data[1] != '/';
+}
+
+/* a link is external when it names a host not in `:internal_hosts` */
+static int
+url_is_external(const struct redcarpet_url_rules *rules, const uint8_t *data, size_t size)
+{
+	size_t i = url_scheme(data, size), start, end;
+
+	if (i + 2 > size || data[i] != '/' || data[i + 1] != '/')
+		return 0;
+
+	start = end = i + 2;
+	while (end < size && data[end] != '/' && data[end] != '?' && data[end] != '#') {
+		if (data[end] == '@')
+			start = end + 1;
+		end++;
+	}
+
+	for (i = start; i < end && data[i] != ':'; ++i);
+	end = i;
+
+	for (i = 0; i < rules->host_count; ++i) {
+		const struct redcarpet_url_rule *host = &rules->hosts[i];
+		size_t j;
+
+		if (host->from_size != end - start)
+			continue;
+
+		for (j = 0; j < host->from_size; ++j) {
+			if (tolower(host->from[j]) != tolower(data[start + j]))
+				break;
+		}
+
+		if (j == host->from_size)
+			return 0;
+	}
+
+	return 1;
+}
+
 static void
 rndr_link_attributes(struct buf *ob, const struct buf *url, void *opaque)
 {
 	struct redcarpet_renderopt *opt = opaque;
-	struct rb_redcarpet_rndr *rndr;
+	const struct redcarpet_url_rules *rules;
+
+	/* the attributes of external links already hold the others */
+	if (opt->url_rules && url) {
+		rules = DATA_PTR(opt->url_rules);
+		if (rules->external_attributes.to_size && url_is_external(rules, url->data, url->size)) {
+			bufput(ob, rules->external_attributes.to, rules->external_attributes.to_size);
+			return;
+		}
+	}
+
+	if (opt->link_attributes)
+		bufput(ob, RSTRING_PTR(opt->link_attributes), RSTRING_LEN(opt->link_attributes));
+}
+
+/* images may have the first of the `:image_prefixes` they start with
+ * replaced; the URLs left relative are joined to the `:base_url` */
+static void
+rndr_link_url(struct buf *ob, const struct buf *url, int image, void *opaque)
+{
+	struct redcarpet_renderopt *opt = opaque;
+	const struct redcarpet_url_rules *rules = DATA_PTR(opt->url_rules);
+	size_t i;
+
+	if (image) {
+		for (i = 0; i < rules->image_count; ++i) {
+			const struct redcarpet_url_rule *prefix = &rules->images[i];
+
+			if (prefix->from_size <= url->size &&
+				memcmp(prefix->from, url->data, prefix->from_size) == 0) {
+				houdini_escape_href(ob, prefix->to, prefix->to_size);
+				houdini_escape_href(ob, url->data + prefix->from_size, url->size - prefix->from_size);
+				return;
+			}
+		}
+	}
+
+	if (rules->base_url.to_size && url_is_relative(url->data, url->size)) {
+		const struct redcarpet_url_rule *base = &rules->base_url;
+		int slashes = (base->to[base->to_size - 1] == '/') + (url->data[0] == '/');
+
+		/* joined by a single slash */
+		houdini_escape_href(ob, base->to, base->to_size - (slashes == 2));
+		if (slashes == 0)
+			bufputc(ob, '/');
+	}
+
+	houdini_escape_href(ob, url->data, url->size);
+}
+
+static void
+url_rule_copy(struct redcarpet_url_rule *rule, VALUE from, VALUE to, uint8_t **data)
+{
+	if (!NIL_P(from)) {
+		rule->from = *data;
+		rule->from_size = RSTRING_LEN(from);
+		memcpy(*data, RSTRING_PTR(from), rule->from_size);
+		*data += rule->from_size;
+	}
+
+	if (!NIL_P(to)) {
+		rule->to = *data;
+		rule->to_size = RSTRING_LEN(to);
+		memcpy(*data, RSTRING_PTR(to), rule->to_size);
+		*data += rule->to_size;
+	}
+}
+
+static int
+cb_merge_attribute(VALUE key, VALUE val, VALUE merged)
+{
+	rb_hash_aset(merged, rb_obj_as_string(key), val);
+	return 0;
+}
+
+/* checks and copies the URL rules into a hidden object that frees
+ * them with the renderer; nil when there are none. External links get
+ * the `:link_attributes` too, those of the same name overridden */
+static VALUE
+rb_redcarpet_url_rules(VALUE base_url, VALUE hosts, VALUE link_attr, VALUE attributes, VALUE images)
+{
+	struct redcarpet_url_rules *rules;
+	size_t bytes = 0, host_count = 0, image_count = 0;
+	uint8_t *data;
+	VALUE pair, rules_obj;
+	long i;
+
+	if (NIL_P(base_url) && NIL_P(hosts) && NIL_P(attributes) && NIL_P(images))
+		return Qnil;
+
+	if (!NIL_P(base_url)) {
+		Check_Type(base_url, T_STRING);
+		bytes += RSTRING_LEN(base_url);
+	}
+
+	if (!NIL_P(hosts)) {
+		Check_Type(hosts, T_ARRAY);
+		for (i = 0; i < RARRAY_LEN(hosts); ++i) {
+			Check_Type(RARRAY_AREF(hosts, i), T_STRING);
+			bytes += RSTRING_LEN(RARRAY_AREF(hosts, i));
+		}
+		host_count = RARRAY_LEN(hosts);
+	}
+
+	if (!NIL_P(attributes)) {
+		Check_Type(attributes, T_HASH);
+		if (!NIL_P(link_attr)) {
+			VALUE merged = rb_hash_new();
+
+			Check_Type(link_attr, T_HASH);
+			rb_hash_foreach(link_attr, &cb_merge_attribute, merged);
+			rb_hash_foreach(attributes, &cb_merge_attribute, merged);
+			attributes = merged;
+		}
+
+		attributes = rb_redcarpet_link_attributes(attributes);
+		bytes += RSTRING_LEN(attributes);
+	}
+
+	if (!NIL_P(images)) {
+		Check_Type(images, T_HASH);
+		images = rb_funcall(images, rb_intern("to_a"), 0);
+		for (i = 0; i < RARRAY_LEN(images); ++i) {
+			pair = RARRAY_AREF(images, i);
+			Check_Type(RARRAY_AREF(pair, 0), T_STRING);
+			Check_Type(RARRAY_AREF(pair, 1), T_STRING);
+			bytes += RSTRING_LEN(RARRAY_AREF(pair, 0)) + RSTRING_LEN(RARRAY_AREF(pair, 1));
+		}
+		image_count = RARRAY_LEN(images);
+	}
+
+	rules = xcalloc(1, sizeof(struct redcarpet_url_rules) +
+		(host_count + image_count) * sizeof(struct redcarpet_url_rule) + bytes);
+	rules_obj = Data_Wrap_Struct(0, NULL, RUBY_DEFAULT_FREE, rules);
+
+	rules->hosts = (struct redcarpet_url_rule *)(rules + 1);
+	rules->host_count = host_count;
+	rules->images = rules->hosts + host_count;
+	rules->image_count = image_count;
+	data = (uint8_t *)(rules->images + image_count);
+
+	url_rule_copy(&rules->base_url, Qnil, base_url, &data);
+	url_rule_copy(&rules->external_attributes, Qnil, attributes, &data);
+
+	for (i = 0; i < (long)host_count; ++i)
+		url_rule_copy(&rules->hosts[i], RARRAY_AREF(hosts, i), Qnil, &data);
+
+	for (i = 0; i < (long)image_count; ++i) {
+		pair = RARRAY_AREF(images, i);
+		url_rule_copy(&rules->images[i], RARRAY_AREF(pair, 0), RARRAY_AREF(pair, 1), &data);
+	}
+
+	RB_GC_GUARD(attributes);
+	RB_GC_GUARD(images);
+	return rules_obj;
+}
+
+struct redcarpet_link {
+	const uint8_t *from;
+	size_t from_size;
+	const uint8_t *to;
+	size_t to_size;
+};
+
+struct redcarpet_link_map {
+	struct buf *text;	/* the text of a resolved autolink, reused */
+	size_t count;
+	struct redcarpet_link links[1];
+};
+
+/* links are ordered by size first, so a lookup mostly compares sizes */
+static int
+link_cmp(const struct redcarpet_link *link, const char *prefix, size_t prefix_size,
+	const uint8_t *data, size_t size)
+{
+	int cmp;
+
+	if (link->from_size != prefix_size + size)
+		return link->from_size < prefix_size + size ? -1 : 1;
+
+	if ((cmp = memcmp(link->from, prefix, prefix_size)) != 0)
+		return cmp;
+
+	return memcmp(link->from + prefix_size, data, size);
+}
+
+static int
+link_sort(const void *a, const void *b)
+{
+	const struct redcarpet_link *other = b;
+	return link_cmp(a, "", 0, other->from, other->from_size);
+}
+
+/* builds the map from the URLs found in the text and the hash
+ * `resolve_links` returned for them, copying both; the URLs it
+ * left out or gave nil for are kept as they are */
+struct redcarpet_link_map *
+rb_redcarpet_link_map_new(VALUE urls, VALUE resolved)
+{
+	struct redcarpet_link_map *map;
+	struct redcarpet_link *link;
+	size_t count = 0, bytes = 0;
+	uint8_t *data;
+	VALUE url, to;
+	long i;
+
+	Check_Type(resolved, T_HASH);
+
+	for (i = 0; i < RARRAY_LEN(urls); ++i) {
+		url = rb_ary_entry(urls, i);
+		to = rb_hash_lookup(resolved, url);
+
+		if (NIL_P(to))
+			continue;
+
+		Check_Type(to, T_STRING);
+		bytes += RSTRING_LEN(url) + RSTRING_LEN(to);
+		count++;
+	}
+
+	if (!count)
+		return NULL;
+
+	map = malloc(sizeof(struct redcarpet_link_map) + (count - 1) * sizeof(struct redcarpet_link) + bytes);
+	if (!map)
+		rb_memerror();
+
+	map->text = NULL;
+	map->count = 0;
+	data = (uint8_t *)(map->links + count);
+
+	for (i = 0; i < RARRAY_LEN(urls) && map->count < count; ++i) {
+		url = rb_ary_entry(urls, i);
+		to = rb_hash_lookup(resolved, url);
+
+		if (!RB_TYPE_P(to, T_STRING))
+			continue;
+
+		link = &map->links[map->count++];
+
+		link->from = data;
+		link->from_size = RSTRING_LEN(url);
+		memcpy(data, RSTRING_PTR(url), link->from_size);
+		data += link->from_size;
+
+		link->to = data;
+		link->to_size = RSTRING_LEN(to);
+		memcpy(data, RSTRING_PTR(to), link->to_size);
+		data += link->to_size;
+	}
+
+	qsort(map->links, map->count, sizeof(struct redcarpet_link), link_sort);
+	return map;
+}
+
+void
+rb_redcarpet_link_map_free(struct redcarpet_link_map *map)
+{
+	if (map)
+		bufrelease(map->text);
+	free(map);
+}
+
+static int
+link_map_find(const struct redcarpet_link_map *map, const char *prefix,
+	const uint8_t *data, size_t size, struct buf *found)
+{
+	size_t lo = 0, hi, mid, prefix_size = strlen(prefix);
+	int cmp;
+
+	if (!map)
+		return 0;
+
+	hi = map->count;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		cmp = link_cmp(&map->links[mid], prefix, prefix_size, data, size);
+
+		if (cmp == 0) {
+			found->data = (uint8_t *)map->links[mid].to;
+			found->size = map->links[mid].to_size;
+			return 1;
+		}
+
+		if (cmp < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return 0;
+}
+
+/* with a `resolve_links`, the links of a render are looked up in the
+ * URLs it returned before reaching the renderer's own callbacks */
+static int
+rndr_link_resolved(struct buf *ob, const struct buf *link, const struct buf *title, const struct buf *content, void *opaque)
+{
+	struct redcarpet_renderopt *opt = opaque;
+	struct buf resolved = { NULL, 0, 0, 0, NULL, NULL };
+
+	if (link && link_map_find(opt->link_map, "", link->data, link->size, &resolved))
+		link = &resolved;
 
-	Data_Get_Struct(opt->self, struct rb_redcarpet_rndr, rndr);
-	Check_Type(opt->link_attributes, T_HASH);
-	rb_hash_foreach(opt->link_attributes, &cb_link_attribute, (VALUE)ob);
+	return opt->resolved_link(ob, link, title, content, opaque);
+}
+
+/* a resolved autolink becomes a link to the new URL, which still
+ * shows the text it was written as; that text is kept with the map,
+ * which goes with the render even when the `link` callback raises */
+static int
+rndr_autolink_resolved(struct buf *ob, const struct buf *link, enum mkd_autolink type, void *opaque)
+{
+	struct redcarpet_renderopt *opt = opaque;
+	struct redcarpet_link_map *map = opt->link_map;
+	struct buf resolved = { NULL, 0, 0, 0, NULL, NULL };
+	size_t skip = 0;
+
+	if (!link || !opt->resolved_link ||
+		!link_map_find(map, type == MKDA_EMAIL ? "mailto:" : "", link->data, link->size, &resolved))
+		return opt->resolved_autolink(ob, link, type, opaque);
+
+	if (bufprefix(link, "mailto:") == 0)
+		skip = 7;
+
+	if (!map->text && (map->text = bufnew(64)) == NULL)
+		return opt->resolved_autolink(ob, link, type, opaque);
+
+	map->text->size = 0;
+	houdini_escape_html0(map->text, link->data + skip, link->size - skip, 0);
+	return opt->resolved_link(ob, &resolved, NULL, map->text, opaque);
 }
 
 static struct sd_callbacks rb_redcarpet_callbacks = {
@@ -315,6 +782,7 @@ static struct sd_callbacks rb_redcarpet_callbacks = {
 	rndr_strikethrough,
 	rndr_superscript,
 	rndr_footnote_ref,
+	rndr_emoji,
 
 	rndr_entity,
 	rndr_normal_text,
@@ -353,6 +821,7 @@ static const char *rb_redcarpet_method_names[] = {
 	"strikethrough",
 	"superscript",
 	"footnote_ref",
+	"emoji",
 
 	"entity",
 	"normal_text",
@@ -363,10 +832,313 @@ static const char *rb_redcarpet_method_names[] = {
 
 static const size_t rb_redcarpet_method_count = sizeof(rb_redcarpet_method_names)/sizeof(char *);
 
+/* the callbacks of the renderers written in C, which their Ruby methods
+ * call whatever a subclass overrides */
+static struct sd_callbacks rb_redcarpet_stripdown_callbacks;
+static struct sd_callbacks rb_redcarpet_manpage_callbacks;
+
+#define CALLBACK_SLOT(name) (offsetof(struct sd_callbacks, name) / sizeof(void *))
+
+static const struct buf *
+rb_redcarpet_arg2buf(struct buf *buf, VALUE str)
+{
+	if (NIL_P(str))
+		return NULL;
+
+	Check_Type(str, T_STRING);
+	buf->data = (uint8_t *)RSTRING_PTR(str);
+	buf->size = RSTRING_LEN(str);
+	return buf;
+}
+
+static int
+rb_redcarpet_arg2list(VALUE type)
+{
+	return type == CSTR2SYM("ordered") ? MKD_LIST_ORDERED : 0;
+}
+
+static int
+rb_redcarpet_arg2align(VALUE align)
+{
+	if (align == CSTR2SYM("left"))
+		return MKD_TABLE_ALIGN_L;
+	if (align == CSTR2SYM("right"))
+		return MKD_TABLE_ALIGN_R;
+	if (align == CSTR2SYM("center"))
+		return MKD_TABLE_ALIGN_CENTER;
+	return 0;
+}
+
+/* a Ruby method of StripDown or ManPage: takes the arguments a Ruby
+ * callback is given, renders them with the C callback of the same name
+ * and returns the result, nil where a span is left as it is */
+static VALUE
+rb_redcarpet_rbase_callback(int argc, VALUE *argv, VALUE self)
+{
+	struct rb_redcarpet_rndr *rndr;
+	const struct sd_callbacks *cb;
+	struct buf in[3] = { { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, { 0, 0, 0, 0 } };
+	const struct buf *a[3] = { NULL, NULL, NULL };
+	const char *name = rb_id2name(rb_frame_this_func());
+	void *opaque;
+	void * const *slots;
+	rb_encoding *enc = NULL;
+	struct buf ob;
+	VALUE result;
+	size_t i;
+	int k, n = 0, text = 0, rendered = 1;
+
+	Data_Get_Struct(self, struct rb_redcarpet_rndr, rndr);
+	opaque = &rndr->options;
+	cb = rndr->options.base_class == rb_cRenderManPage ?
+		&rb_redcarpet_manpage_callbacks : &rb_redcarpet_stripdown_callbacks;
+	slots = (void * const *)cb;
+
+	for (i = 0; i < rb_redcarpet_method_count; ++i) {
+		if (strcmp(name, rb_redcarpet_method_names[i]) == 0)
+			break;
+	}
+
+	if (i == rb_redcarpet_method_count || !slots[i])
+		rb_notimplement();
+
+	switch (i) {
+	case CALLBACK_SLOT(hrule):
+	case CALLBACK_SLOT(linebreak):
+	case CALLBACK_SLOT(doc_header):
+	case CALLBACK_SLOT(doc_footer):
+		break;
+
+	case CALLBACK_SLOT(footnote_ref):
+		n = 1;
+		break;
+
+	case CALLBACK_SLOT(header):
+	case CALLBACK_SLOT(list):
+	case CALLBACK_SLOT(listitem):
+	case CALLBACK_SLOT(table_cell):
+	case CALLBACK_SLOT(footnote_def):
+	case CALLBACK_SLOT(autolink):
+		n = 2;
+		text = 1;
+		break;
+
+	case CALLBACK_SLOT(blockcode):
+	case CALLBACK_SLOT(table):
+	case CALLBACK_SLOT(emoji):
+		n = text = 2;
+		break;
+
+	case CALLBACK_SLOT(image):
+	case CALLBACK_SLOT(link):
+		n = text = 3;
+		break;
+
+	default:
+		n = text = 1;
+		break;
+	}
+
+	rb_check_arity(argc, n, n);
+
+	for (k = 0; k < text; ++k) {
+		a[k] = rb_redcarpet_arg2buf(&in[k], argv[k]);
+		if (a[k] && !enc)
+			enc = rb_enc_get(argv[k]);
+	}
+
+	result = rb_redcarpet_outbuf_new(&ob, 64);
+
+	switch (i) {
+	case CALLBACK_SLOT(blockcode):
+		cb->blockcode(&ob, a[0], a[1], opaque);
+		break;
+	case CALLBACK_SLOT(header):
+		cb->header(&ob, a[0], NUM2INT(argv[1]), opaque);
+		break;
+	case CALLBACK_SLOT(hrule):
+		cb->hrule(&ob, opaque);
+		break;
+	case CALLBACK_SLOT(list):
+		cb->list(&ob, a[0], rb_redcarpet_arg2list(argv[1]), opaque);
+		break;
+	case CALLBACK_SLOT(listitem):
+		cb->listitem(&ob, a[0], rb_redcarpet_arg2list(argv[1]), opaque);
+		break;
+	case CALLBACK_SLOT(table):
+		cb->table(&ob, a[0], a[1], opaque);
+		break;
+	case CALLBACK_SLOT(table_cell):
+		cb->table_cell(&ob, a[0], rb_redcarpet_arg2align(argv[1]), opaque);
+		break;
+	case CALLBACK_SLOT(footnote_def):
+		cb->footnote_def(&ob, a[0], NUM2UINT(argv[1]), opaque);
+		break;
+	case CALLBACK_SLOT(autolink):
+		rendered = cb->autolink(&ob, a[0],
+			argv[1] == CSTR2SYM("email") ? MKDA_EMAIL : MKDA_NORMAL, opaque);
+		break;
+	case CALLBACK_SLOT(image):
+		rendered = cb->image(&ob, a[0], a[1], a[2], opaque);
+		break;
+	case CALLBACK_SLOT(linebreak):
+		rendered = cb->linebreak(&ob, opaque);
+		break;
+	case CALLBACK_SLOT(link):
+		rendered = cb->link(&ob, a[0], a[1], a[2], opaque);
+		break;
+	case CALLBACK_SLOT(footnote_ref):
+		rendered = cb->footnote_ref(&ob, NUM2UINT(argv[0]), opaque);
+		break;
+	case CALLBACK_SLOT(emoji):
+		rendered = cb->emoji(&ob, a[0], a[1], opaque);
+		break;
+	case CALLBACK_SLOT(doc_header):
+		cb->doc_header(&ob, opaque);
+		break;
+	case CALLBACK_SLOT(doc_footer):
+		cb->doc_footer(&ob, opaque);
+		break;
+
+	default:
+		if (i >= CALLBACK_SLOT(autolink) && i <= CALLBACK_SLOT(emoji))
+			rendered = ((int (*)(struct buf *, const struct buf *, void *))slots[i])(&ob, a[0], opaque);
+		else
+			((void (*)(struct buf *, const struct buf *, void *))slots[i])(&ob, a[0], opaque);
+		break;
+	}
+
+	result = rb_redcarpet_outbuf_finish(&ob, enc ? enc : rb_utf8_encoding());
+	return rendered ? result : Qnil;
+}
+
+/* the Ruby methods of a renderer written in C, one for each of its
+ * callbacks */
+static void
+rb_redcarpet_define_callbacks(VALUE klass, const struct sd_callbacks *callbacks)
+{
+	void * const *cb = (void * const *)callbacks;
+	size_t i;
+
+	for (i = 0; i < rb_redcarpet_method_count; ++i) {
+		if (cb[i])
+			rb_define_method(klass, rb_redcarpet_method_names[i], rb_redcarpet_rbase_callback, -1);
+	}
+}
+
 static void rb_redcarpet_rbase_mark(struct rb_redcarpet_rndr *rndr)
 {
 	if (rndr->options.link_attributes)
 		rb_gc_mark(rndr->options.link_attributes);
+	if (rndr->options.url_rules)
+		rb_gc_mark(rndr->options.url_rules);
+	if (rndr->options.allowlist)
+		rb_gc_mark(rndr->options.allowlist);
+	if (rndr->options.emoji_image)
+		rb_gc_mark(rndr->options.emoji_image);
+}
+
+/* `:emoji_image`, copied into a hidden object that frees it with the
+ * renderer */
+static VALUE
+rb_redcarpet_emoji_image(VALUE image)
+{
+	const char *template = StringValueCStr(image);
+	size_t size = strlen(template) + 1;
+	VALUE image_obj;
+	char *copy;
+
+	copy = xmalloc(size);
+	image_obj = Data_Wrap_Struct(0, NULL, RUBY_DEFAULT_FREE, copy);
+	memcpy(copy, template, size);
+
+	return image_obj;
+}
+
+/* the names of `:allowed_tags`, as lowercase strings */
+static VALUE
+allowlist_name(VALUE name)
+{
+	if (SYMBOL_P(name))
+		name = rb_sym2str(name);
+
+	Check_Type(name, T_STRING);
+	return rb_funcall(name, rb_intern("downcase"), 0);
+}
+
+static void
+allowlist_copy(const char **to, VALUE name, char **data)
+{
+	*to = *data;
+	memcpy(*data, RSTRING_PTR(name), RSTRING_LEN(name));
+	*data += RSTRING_LEN(name);
+	*(*data)++ = 0;
+}
+
+/* checks and copies the `:allowed_tags` into a hidden object that
+ * frees them with the renderer */
+static VALUE
+rb_redcarpet_allowlist(VALUE allowed)
+{
+	struct html_allowlist *allowlist;
+	struct html_allowed_tag *tag;
+	const char **attribute;
+	size_t bytes = 0, attribute_count = 0;
+	VALUE tags, pair, attributes, allowlist_obj;
+	char *data;
+	long i, j;
+
+	Check_Type(allowed, T_HASH);
+
+	/* a list of [name, [attribute, ...]] with every name checked first,
+	 * so that nothing can raise once the copy is made */
+	tags = rb_ary_new();
+	pair = rb_funcall(allowed, rb_intern("to_a"), 0);
+	for (i = 0; i < RARRAY_LEN(pair); ++i) {
+		VALUE entry = RARRAY_AREF(pair, i);
+		VALUE names = rb_ary_new();
+
+		attributes = RARRAY_AREF(entry, 1);
+		if (!NIL_P(attributes)) {
+			Check_Type(attributes, T_ARRAY);
+			for (j = 0; j < RARRAY_LEN(attributes); ++j) {
+				VALUE name = allowlist_name(RARRAY_AREF(attributes, j));
+				rb_ary_push(names, name);
+				bytes += RSTRING_LEN(name) + 1;
+			}
+		}
+
+		rb_ary_push(tags, rb_assoc_new(allowlist_name(RARRAY_AREF(entry, 0)), names));
+		bytes += RSTRING_LEN(RARRAY_AREF(RARRAY_AREF(tags, i), 0)) + 1;
+		attribute_count += RARRAY_LEN(names);
+	}
+
+	allowlist = xcalloc(1, sizeof(struct html_allowlist) +
+		RARRAY_LEN(tags) * sizeof(struct html_allowed_tag) +
+		attribute_count * sizeof(const char *) + bytes);
+	allowlist_obj = Data_Wrap_Struct(0, NULL, RUBY_DEFAULT_FREE, allowlist);
+
+	tag = (struct html_allowed_tag *)(allowlist + 1);
+	attribute = (const char **)(tag + RARRAY_LEN(tags));
+	data = (char *)(attribute + attribute_count);
+
+	allowlist->count = RARRAY_LEN(tags);
+	allowlist->tags = tag;
+
+	for (i = 0; i < RARRAY_LEN(tags); ++i, ++tag) {
+		pair = RARRAY_AREF(tags, i);
+		attributes = RARRAY_AREF(pair, 1);
+
+		allowlist_copy(&tag->name, RARRAY_AREF(pair, 0), &data);
+		tag->attributes = attribute;
+		tag->attribute_count = RARRAY_LEN(attributes);
+
+		for (j = 0; j < RARRAY_LEN(attributes); ++j)
+			allowlist_copy(attribute++, RARRAY_AREF(attributes, j), &data);
+	}
+
+	RB_GC_GUARD(tags);
+	return allowlist_obj;
 }
 
 static VALUE rb_redcarpet_rbase_alloc(VALUE klass)
@@ -376,6 +1148,21 @@ static VALUE rb_redcarpet_rbase_alloc(VALUE klass)
 	return Data_Wrap_Struct(klass, rb_redcarpet_rbase_mark, NULL, rndr);
 }
 
+/* the methods that StripDown and ManPage define in C only stand for
+ * their own callbacks, which are left as they are */
+static int
+rb_redcarpet__overridden(VALUE self, VALUE base_class, ID name)
+{
+	VALUE method;
+
+	if (!rb_respond_to(self, name))
+		return 0;
+
+	method = rb_obj_method(self, ID2SYM(name));
+	return rb_funcall(method, rb_intern("owner"), 0) != base_class ||
+		!NIL_P(rb_funcall(method, rb_intern("source_location"), 0));
+}
+
 static void rb_redcarpet__overload(VALUE self, VALUE base_class)
 {
 	struct rb_redcarpet_rndr *rndr;
@@ -395,9 +1182,30 @@ static void rb_redcarpet__overload(VALUE self, VALUE base_class)
 		size_t i;
 
 		for (i = 0; i < rb_redcarpet_method_count; ++i) {
-			if (rb_respond_to(self, rb_intern(rb_redcarpet_method_names[i])))
+			if (rb_redcarpet__overridden(self, base_class, rb_intern(rb_redcarpet_method_names[i])))
 				dest[i] = source[i];
 		}
+
+		/* a Ruby `table` needs the header and body as a whole */
+		if (rndr->callbacks.table == rndr_table) {
+			rndr->callbacks.table_open = NULL;
+			rndr->callbacks.table_close = NULL;
+		}
+
+		if (rb_respond_to(self, rb_intern("block_code_batch"))) {
+			rndr->callbacks.blockcode = rndr_blockcode_batch;
+			rndr->options.code_batch = 1;
+		}
+
+		if (rb_respond_to(self, rb_intern("resolve_links"))) {
+			rndr->options.resolved_link = rndr->callbacks.link;
+			rndr->options.resolved_autolink = rndr->callbacks.autolink;
+
+			if (rndr->callbacks.link)
+				rndr->callbacks.link = rndr_link_resolved;
+			if (rndr->callbacks.autolink)
+				rndr->callbacks.autolink = rndr_autolink_resolved;
+		}
 	}
 }
 
@@ -411,7 +1219,7 @@ static VALUE rb_redcarpet_html_init(int argc, VALUE *argv, VALUE self)
 {
 	struct rb_redcarpet_rndr *rndr;
 	unsigned int render_flags = 0;
-	VALUE hash, link_attr = Qnil;
+	VALUE hash, link_attr = Qnil, url_rules = Qnil, allowlist = Qnil, emoji_image = Qnil;
 
 	Data_Get_Struct(self, struct rb_redcarpet_rndr, rndr);
 
@@ -456,16 +1264,47 @@ static VALUE rb_redcarpet_html_init(int argc, VALUE *argv, VALUE self)
 			render_flags |= HTML_USE_XHTML;
 
 		link_attr = rb_hash_aref(hash, CSTR2SYM("link_attributes"));
+
+		url_rules = rb_redcarpet_url_rules(
+			rb_hash_aref(hash, CSTR2SYM("base_url")),
+			rb_hash_aref(hash, CSTR2SYM("internal_hosts")),
+			link_attr,
+			rb_hash_aref(hash, CSTR2SYM("external_link_attributes")),
+			rb_hash_aref(hash, CSTR2SYM("image_prefixes")));
+
+		allowlist = rb_hash_aref(hash, CSTR2SYM("allowed_tags"));
+		if (!NIL_P(allowlist))
+			allowlist = rb_redcarpet_allowlist(allowlist);
+
+		emoji_image = rb_hash_aref(hash, CSTR2SYM("emoji_image"));
+		if (!NIL_P(emoji_image))
+			emoji_image = rb_redcarpet_emoji_image(emoji_image);
 	}
 
 	sdhtml_renderer(&rndr->callbacks, (struct html_renderopt *)&rndr->options.html, render_flags);
 	rb_redcarpet__overload(self, rb_cRenderHTML);
 
 	if (!NIL_P(link_attr)) {
-		rndr->options.link_attributes = link_attr;
+		rndr->options.link_attributes = rb_redcarpet_link_attributes(link_attr);
 		rndr->options.html.link_attributes = &rndr_link_attributes;
 	}
 
+	if (!NIL_P(url_rules)) {
+		rndr->options.url_rules = url_rules;
+		rndr->options.html.link_attributes = &rndr_link_attributes;
+		rndr->options.html.link_url = &rndr_link_url;
+	}
+
+	if (!NIL_P(allowlist)) {
+		rndr->options.allowlist = allowlist;
+		rndr->options.html.allowlist = DATA_PTR(allowlist);
+	}
+
+	if (!NIL_P(emoji_image)) {
+		rndr->options.emoji_image = emoji_image;
+		rndr->options.html.emoji_image = DATA_PTR(emoji_image);
+	}
+
 	return Qnil;
 }
 
@@ -499,24 +1338,48 @@ static VALUE rb_redcarpet_htmltoc_init(int argc, VALUE *argv, VALUE self)
 	return Qnil;
 }
 
+static VALUE rb_redcarpet_stripdown_init(VALUE self)
+{
+	struct rb_redcarpet_rndr *rndr;
+
+	Data_Get_Struct(self, struct rb_redcarpet_rndr, rndr);
+
+	sdhtml_stripdown_renderer(&rndr->callbacks, (struct html_renderopt *)&rndr->options.html);
+	rb_redcarpet__overload(self, rb_cRenderStripDown);
+
+	return Qnil;
+}
+
+static VALUE rb_redcarpet_manpage_init(VALUE self)
+{
+	struct rb_redcarpet_rndr *rndr;
+
+	Data_Get_Struct(self, struct rb_redcarpet_rndr, rndr);
+
+	sdman_renderer(&rndr->callbacks);
+	rb_redcarpet__overload(self, rb_cRenderManPage);
+
+	return Qnil;
+}
+
 static VALUE rb_redcarpet_smartypants_render(VALUE self, VALUE text)
 {
 	VALUE result;
-	struct buf *output_buf;
+	struct buf output_buf;
 
 	Check_Type(text, T_STRING);
 
-	output_buf = bufnew(128);
+	result = rb_redcarpet_outbuf_new(&output_buf, RSTRING_LEN(text) + RSTRING_LEN(text) / 8);
+	sdhtml_smartypants(&output_buf, (const uint8_t*)RSTRING_PTR(text), RSTRING_LEN(text));
+	result = rb_redcarpet_outbuf_finish(&output_buf, rb_enc_get(text));
 
-	sdhtml_smartypants(output_buf, (const uint8_t*)RSTRING_PTR(text), RSTRING_LEN(text));
-	result = rb_enc_str_new((const char*)output_buf->data, output_buf->size, rb_enc_get(text));
-
-	bufrelease(output_buf);
 	return result;
 }
 
 void Init_redcarpet_rndr()
 {
+	struct html_renderopt stripdown_options;
+
 	rb_mRender = rb_define_module_under(rb_mRedcarpet, "Render");
 
 	rb_cRenderBase = rb_define_class_under(rb_mRender, "Base", rb_cObject);
@@ -529,6 +1392,16 @@ void Init_redcarpet_rndr()
 	rb_cRenderHTML_TOC = rb_define_class_under(rb_mRender, "HTML_TOC", rb_cRenderBase);
 	rb_define_method(rb_cRenderHTML_TOC, "initialize", rb_redcarpet_htmltoc_init, -1);
 
+	rb_cRenderStripDown = rb_define_class_under(rb_mRender, "StripDown", rb_cRenderBase);
+	rb_define_method(rb_cRenderStripDown, "initialize", rb_redcarpet_stripdown_init, 0);
+	sdhtml_stripdown_renderer(&rb_redcarpet_stripdown_callbacks, &stripdown_options);
+	rb_redcarpet_define_callbacks(rb_cRenderStripDown, &rb_redcarpet_stripdown_callbacks);
+
+	rb_cRenderManPage = rb_define_class_under(rb_mRender, "ManPage", rb_cRenderBase);
+	rb_define_method(rb_cRenderManPage, "initialize", rb_redcarpet_manpage_init, 0);
+	sdman_renderer(&rb_redcarpet_manpage_callbacks);
+	rb_redcarpet_define_callbacks(rb_cRenderManPage, &rb_redcarpet_manpage_callbacks);
+
 	rb_mSmartyPants = rb_define_module_under(rb_mRender, "SmartyPants");
 	rb_define_method(rb_mSmartyPants, "postprocess", rb_redcarpet_smartypants_render, 1);
 }
@@ -9,17 +9,39 @@
 
 #include "markdown.h"
 #include "html.h"
+#include "man.h"
+#include "stats.h"
 
 #define CSTR2SYM(s) (ID2SYM(rb_intern((s))))
 
+/* brackets the number of a code block left for `block_code_batch` */
+#define REDCARPET_CODE_MARK '\x1a'
+
 void Init_redcarpet_rndr();
 
+VALUE rb_redcarpet_outbuf_new(struct buf *ob, size_t capa);
+VALUE rb_redcarpet_outbuf_finish(struct buf *ob, rb_encoding *enc);
+
+/* the URLs `resolve_links` gave for the links of a render */
+struct redcarpet_link_map;
+
+struct redcarpet_link_map *rb_redcarpet_link_map_new(VALUE urls, VALUE resolved);
+void rb_redcarpet_link_map_free(struct redcarpet_link_map *map);
+
 struct redcarpet_renderopt {
 	struct html_renderopt html;
 	VALUE link_attributes;
+	VALUE url_rules;
+	VALUE allowlist;
+	VALUE emoji_image;
 	VALUE self;
 	VALUE base_class;
 	rb_encoding *active_enc;
+	int code_batch;
+	VALUE code_blocks;
+	int (*resolved_link)(struct buf *ob, const struct buf *link, const struct buf *title, const struct buf *content, void *opaque);
+	int (*resolved_autolink)(struct buf *ob, const struct buf *link, enum mkd_autolink type, void *opaque);
+	struct redcarpet_link_map *link_map;
 };
 
 struct rb_redcarpet_rndr {
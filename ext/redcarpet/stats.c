@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2011, Vicent Marti
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "markdown.h"
+#include "stats.h"
+#include <string.h>
+#include <ctype.h>
+
+/* nothing is ever written out: every callback only counts, and block
+ * callbacks end the word their text finished on. Normal text is the
+ * exception, as autolinks take back the scheme or the local part they
+ * start with from what it wrote; it only ever lands in the parser's
+ * own span buffers, since the output doesn't grow */
+
+#define STATS(opaque) ((struct sd_stats *)(opaque))
+
+static void
+count_text(struct sd_stats *stats, const uint8_t *data, size_t size)
+{
+	size_t i;
+
+	for (i = 0; i < size; ++i) {
+		uint8_t c = data[i];
+
+		if (c == ' ' || (c >= '\t' && c <= '\r')) {
+			stats->in_word = 0;
+			if (c != '\n')
+				stats->chars++;
+			continue;
+		}
+
+		if ((c & 0xC0) == 0x80)
+			continue; /* UTF-8 continuation byte */
+
+		/* punctuation on its own is no word */
+		if (!stats->in_word && (isalnum(c) || c >= 0x80)) {
+			stats->in_word = 1;
+			stats->words++;
+		}
+
+		stats->chars++;
+	}
+}
+
+/********************
+ * BLOCK CALLBACKS *
+ ********************/
+
+static void
+stats_blockcode(struct buf *ob, const struct buf *text, const struct buf *lang, void *opaque)
+{
+	struct sd_stats *stats = STATS(opaque);
+
+	stats->code_blocks++;
+	if (text) {
+		const uint8_t *p = text->data, *end = text->data + text->size;
+
+		while (p < end && (p = memchr(p, '\n', end - p)) != NULL) {
+			stats->code_lines++;
+			p++;
+		}
+	}
+
+	stats->in_word = 0;
+}
+
+static void
+stats_blockquote(struct buf *ob, const struct buf *text, void *opaque)
+{
+	STATS(opaque)->blockquotes++;
+	STATS(opaque)->in_word = 0;
+}
+
+static void
+stats_blockhtml(struct buf *ob, const struct buf *text, void *opaque)
+{
+	STATS(opaque)->html_blocks++;
+	STATS(opaque)->in_word = 0;
+}
+
+static void
+stats_header(struct buf *ob, const struct buf *text, int level, void *opaque)
+{
+	STATS(opaque)->headers++;
+	STATS(opaque)->in_word = 0;
+}
+
+static void
+stats_hrule(struct buf *ob, void *opaque)
+{
+	STATS(opaque)->hrules++;
+	STATS(opaque)->in_word = 0;
+}
+
+static void
+stats_list(struct buf *ob, const struct buf *text, int flags, void *opaque)
+{
+	STATS(opaque)->lists++;
+	STATS(opaque)->in_word = 0;
+}
+
+static void
+stats_listitem(struct buf *ob, const struct buf *text, int flags, void *opaque)
+{
+	STATS(opaque)->list_items++;
+	STATS(opaque)->in_word = 0;
+}
+
+static void
+stats_paragraph(struct buf *ob, const struct buf *text, void *opaque)
+{
+	STATS(opaque)->paragraphs++;
+	STATS(opaque)->in_word = 0;
+}
+
+static void
+stats_table(struct buf *ob, const struct buf *header, const struct buf *body, void *opaque)
+{
+	STATS(opaque)->tables++;
+	STATS(opaque)->in_word = 0;
+}
+
+static void
+stats_tablerow(struct buf *ob, const struct buf *text, void *opaque)
+{
+	STATS(opaque)->in_word = 0;
+}
+
+static void
+stats_tablecell(struct buf *ob, const struct buf *text, int flags, void *opaque)
+{
+	STATS(opaque)->in_word = 0;
+}
+
+static void
+stats_footnote_def(struct buf *ob, const struct buf *text, unsigned int num, void *opaque)
+{
+	STATS(opaque)->footnotes++;
+	STATS(opaque)->in_word = 0;
+}
+
+/*******************
+ * SPAN CALLBACKS *
+ *******************/
+
+static int
+stats_autolink(struct buf *ob, const struct buf *link, enum mkd_autolink type, void *opaque)
+{
+	STATS(opaque)->links++;
+	return 1;
+}
+
+static int
+stats_link(struct buf *ob, const struct buf *link, const struct buf *title, const struct buf *content, void *opaque)
+{
+	STATS(opaque)->links++;
+	return 1;
+}
+
+static int
+stats_image(struct buf *ob, const struct buf *link, const struct buf *title, const struct buf *alt, void *opaque)
+{
+	STATS(opaque)->images++;
+	return 1;
+}
+
+static int
+stats_linebreak(struct buf *ob, void *opaque)
+{
+	STATS(opaque)->in_word = 0;
+	return 1;
+}
+
+/* the text of these spans was counted as it went by */
+static int
+stats_span(struct buf *ob, const struct buf *text, void *opaque)
+{
+	return 1;
+}
+
+static int
+stats_footnote_ref(struct buf *ob, unsigned int num, void *opaque)
+{
+	return 1;
+}
+
+/**********************
+ * LOW LEVEL CALLBACKS *
+ **********************/
+
+static void
+stats_entity(struct buf *ob, const struct buf *entity, void *opaque)
+{
+	struct sd_stats *stats = STATS(opaque);
+
+	if (!stats->in_word) {
+		stats->in_word = 1;
+		stats->words++;
+	}
+
+	stats->chars++;
+}
+
+static void
+stats_normal_text(struct buf *ob, const struct buf *text, void *opaque)
+{
+	if (text) {
+		count_text(STATS(opaque), text->data, text->size);
+		bufput(ob, text->data, text->size);
+	}
+}
+
+void
+sdstats_renderer(struct sd_callbacks *callbacks)
+{
+	static const struct sd_callbacks cb_default = {
+		stats_blockcode,
+		stats_blockquote,
+		stats_blockhtml,
+		stats_header,
+		stats_hrule,
+		stats_list,
+		stats_listitem,
+		stats_paragraph,
+		stats_table,
+		stats_tablerow,
+		stats_tablecell,
+		NULL,
+		stats_footnote_def,
+
+		stats_autolink,
+		stats_span,
+		stats_span,
+		stats_span,
+		stats_span,
+		stats_span,
+		NULL,
+		stats_image,
+		stats_linebreak,
+		stats_link,
+		stats_span,
+		stats_span,
+		stats_span,
+		stats_span,
+		stats_footnote_ref,
+		NULL,
+
+		stats_entity,
+		stats_normal_text,
+
+		NULL,
+		NULL,
+
+		NULL,
+		NULL,
+	};
+
+	memcpy(callbacks, &cb_default, sizeof(struct sd_callbacks));
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2011, Vicent Marti
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef STATS_H__
+#define STATS_H__
+
+#include "markdown.h"
+#include "buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* sd_stats - what a document is made of, counted while it is parsed */
+struct sd_stats {
+	size_t words;
+	size_t chars;		/* characters of text, newlines aside */
+
+	size_t headers;
+	size_t paragraphs;
+	size_t lists;
+	size_t list_items;
+	size_t blockquotes;
+	size_t code_blocks;
+	size_t code_lines;
+	size_t tables;
+	size_t hrules;
+	size_t html_blocks;
+	size_t footnotes;
+
+	size_t links;
+	size_t images;
+
+	int in_word;
+};
+
+/* sdstats_renderer - callbacks that only count, for `struct sd_stats` as opaque */
+extern void
+sdstats_renderer(struct sd_callbacks *callbacks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
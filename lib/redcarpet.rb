@@ -8,6 +8,20 @@ module Redcarpet
     attr_reader :renderer
   end
 
+  # Raised by Markdown#render when a render runs past one of the limits
+  # it was given. +reason+ is the limit that ran out (:timeout,
+  # :max_output or :max_triggers) and +partial+ what was rendered until
+  # then.
+  class RenderLimitExceeded < StandardError
+    attr_reader :reason, :partial
+
+    def initialize(reason, partial)
+      super("render stopped early: #{reason} exceeded")
+      @reason = reason
+      @partial = partial
+    end
+  end
+
   module Render
 
     # XHTML Renderer
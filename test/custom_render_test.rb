@@ -25,4 +25,138 @@ class CustomRenderTest < Redcarpet::TestCase
     assert_equal(nil,md.render("Anything"))
   end
 
+  class NoTextRender < Redcarpet::Render::HTML
+    def normal_text(text)
+      ""
+    end
+  end
+
+  def test_autolink_after_dropped_text
+    md = Redcarpet::Markdown.new(NoTextRender, :autolink => true)
+    assert_equal "", md.render("Contact foo@example.com or http://example.com")
+  end
+
+  class TableRender < Redcarpet::Render::HTML
+    def table(header, body)
+      "<table class=\"cool\">#{header}|#{body}</table>"
+    end
+  end
+
+  def test_table_overload_gets_header_and_body
+    md = Redcarpet::Markdown.new(TableRender, :tables => true)
+    output = md.render("a | b\n---|---\nc | d\n")
+
+    assert_match %r{<table class="cool"><tr>\n<th>a</th>}, output
+    assert_match %r{</tr>\n\|<tr>\n<td>c</td>}, output
+  end
+
+  class BatchCodeRender < Redcarpet::Render::HTML
+    attr_reader :batches
+
+    def block_code_batch(blocks)
+      (@batches ||= []) << blocks
+      blocks.map { |code, language| language && "<pre class=\"#{language}\">#{code.strip}</pre>\n" }
+    end
+  end
+
+  def test_block_code_batch_gets_every_code_block_at_once
+    renderer = BatchCodeRender.new
+    md = Redcarpet::Markdown.new(renderer, :fenced_code_blocks => true)
+    output = md.render("```ruby\nputs 1\n```\n\n> ```c\n> x;\n> ```\n\n    plain\n")
+
+    assert_equal [[["puts 1\n", "ruby"], ["x;\n", "c"], ["plain\n", nil]]], renderer.batches
+    assert_equal "<pre class=\"ruby\">puts 1</pre>\n\n<blockquote>\n<pre class=\"c\">x;</pre>\n</blockquote>\n", output
+  end
+
+  def test_block_code_batch_with_the_placeholder_mark_in_the_text
+    renderer = BatchCodeRender.new
+    md = Redcarpet::Markdown.new(renderer, :fenced_code_blocks => true)
+    output = md.render("\x1a0\x1a\n\n```a\nb\n```\n\n```c\nd\n```\n")
+
+    assert_equal 2, renderer.batches.size
+    assert_equal "<p>\x1a0\x1a</p>\n<pre class=\"a\">b</pre>\n<pre class=\"c\">d</pre>\n", output
+  end
+
+  class ResolvingRender < Redcarpet::Render::HTML
+    attr_reader :resolved
+
+    def resolve_links(urls)
+      (@resolved ||= []) << urls
+      { "/a" => "/b", "/r" => nil, "mailto:me@example.com" => "mailto:you@example.com",
+        "http://example.com" => "https://example.com/" }
+    end
+  end
+
+  def test_resolve_links_gets_every_link_target_at_once
+    renderer = ResolvingRender.new
+    md = Redcarpet::Markdown.new(renderer, :autolink => true)
+    output = md.render("[a](/a) [b][r] ![c](/a) me@example.com <http://example.com> [d](/a)\n\n[r]: /r\n")
+
+    assert_equal [["/a", "/r", "mailto:me@example.com", "http://example.com"]], renderer.resolved
+    html_equal "<p><a href=\"/b\">a</a> <a href=\"/r\">b</a> <img src=\"/a\" alt=\"c\"> " \
+      "<a href=\"mailto:you@example.com\">me@example.com</a> " \
+      "<a href=\"https://example.com/\">http://example.com</a> <a href=\"/b\">d</a></p>\n", output
+  end
+
+  def test_resolve_links_is_not_called_without_links
+    renderer = ResolvingRender.new
+    Redcarpet::Markdown.new(renderer).render("no *links* here")
+
+    assert_nil renderer.resolved
+  end
+
+  class RaisingResolvingRender < ResolvingRender
+    def link(link, title, content)
+      raise ArgumentError if content == "me@example.com"
+      "<a href=\"#{link}\">#{content}</a>"
+    end
+  end
+
+  def test_raising_link_with_resolved_autolinks
+    md = Redcarpet::Markdown.new(RaisingResolvingRender.new, :autolink => true)
+
+    10.times do
+      assert_raise(ArgumentError) { md.render("[a](/a) me@example.com") }
+    end
+
+    html_equal "<p><a href=\"/b\">a</a></p>\n", md.render("[a](/a)")
+  end
+
+  class YieldingRender < Redcarpet::Render::HTML
+    def emphasis(text)
+      raise ArgumentError if text == "boom"
+      Thread.pass
+      "<em>#{text}</em>"
+    end
+  end
+
+  def test_one_instance_shared_between_threads
+    md = Redcarpet::Markdown.new(YieldingRender, :footnotes => true).freeze
+    docs = (1..4).map { |i| "[a][r] *b#{i}* c[^n]\n\n[r]: /#{i}\n[^n]: *d#{i}*\n" }
+    expected = docs.map { |doc| md.render(doc) }
+
+    threads = docs.map do |doc|
+      Thread.new { Array.new(50) { md.render(doc) }.uniq }
+    end
+
+    assert_equal expected.map { |html| [html] }, threads.map(&:value)
+  end
+
+  def test_raising_callback_leaves_instance_usable
+    md = Redcarpet::Markdown.new(YieldingRender)
+
+    assert_raise(ArgumentError) { md.render("[*boom*](/a)") }
+    html_equal "<p><a href=\"/b\">c</a> <em>d</em></p>\n", md.render("[c](/b) *d*")
+  end
+
+  def test_raising_callback_in_a_loop
+    md = Redcarpet::Markdown.new(YieldingRender)
+    text = "[a](/a) [b](/b) _c_ *boom* [d](/d) _e_ *f*"
+
+    100.times do
+      assert_raise(ArgumentError) { md.render(text) }
+    end
+
+    html_equal "<p><a href=\"/b\">c</a> <em>d</em></p>\n", md.render("[c](/b) *d*")
+  end
 end
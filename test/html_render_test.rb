@@ -33,6 +33,20 @@ EOE
     html_equal "<p>Through NO DOUBLE NO</p>\n", output
   end
 
+  def test_allowed_tags_in_inline_html
+    markdown = %(<em class="x" onclick="y">a</em> <b>b</b> <a href="javascript:alert(1)" title='"c"'>c</a> <a href="/d">d</a>)
+    output   = render(markdown, with: { allowed_tags: { em: [], a: [:href, :title] } })
+
+    assert_equal %(<p><em>a</em> b <a title="&quot;c&quot;">c</a> <a href="/d">d</a></p>\n), output
+  end
+
+  def test_allowed_tags_in_html_blocks
+    markdown = %(<div class="box" style="x">\n<script>alert(1)</script><!-- note -->\n<img src="http://a.org/a.png" onerror="y"> 1 < 2\n</div>\n)
+    output   = render(markdown, with: { allowed_tags: { "div" => ["class"], "img" => ["src"] } })
+
+    assert_equal %(<div class="box">\n\n<img src="http://a.org/a.png"> 1 &lt; 2\n</div>\n), output
+  end
+
   def test_filter_html_doesnt_break_two_space_hard_break
     markdown = "Lorem,  \nipsum\n"
     output   = render(markdown, with: [:filter_html])
@@ -80,6 +94,64 @@ EOE
     assert md.render('This is a [simple](http://test.com) test.').include?('rel="blank"')
   end
 
+  def test_that_link_attributes_are_escaped
+    rndr = Redcarpet::Render::HTML.new(:link_attributes => {:title => 'a "b" & <c>', :tabindex => 1})
+    md = Redcarpet::Markdown.new(rndr)
+
+    assert_equal %(<p><a href="/x" title="a &quot;b&quot; &amp; &lt;c&gt;" tabindex="1">y</a></p>\n),
+      md.render('[y](/x)')
+  end
+
+  def test_base_url_is_joined_to_relative_urls
+    rndr = Redcarpet::Render::HTML.new(:base_url => "https://example.com/docs/")
+    md = Redcarpet::Markdown.new(rndr)
+    output = md.render("[a](intro) [b](/faq) [c](#top) [d](http://a.org/x) [e](//a.org/) ![f](img/f.png)")
+
+    assert_equal %(<p><a href="https://example.com/docs/intro">a</a> <a href="https://example.com/docs/faq">b</a> ) +
+      %(<a href="#top">c</a> <a href="http://a.org/x">d</a> <a href="//a.org/">e</a> ) +
+      %(<img src="https://example.com/docs/img/f.png" alt="f"></p>\n), output
+  end
+
+  def test_external_link_attributes
+    rndr = Redcarpet::Render::HTML.new(:internal_hosts => ["example.com"],
+      :external_link_attributes => {:rel => "nofollow noopener"})
+    md = Redcarpet::Markdown.new(rndr, :autolink => true)
+    output = md.render("[a](/x) [b](https://Example.com:443/) [c](https://a.org/) http://b.org me@example.org")
+
+    assert_equal %(<p><a href="/x">a</a> <a href="https://Example.com:443/">b</a> ) +
+      %(<a href="https://a.org/" rel="nofollow noopener">c</a> ) +
+      %(<a href="http://b.org" rel="nofollow noopener">http://b.org</a> ) +
+      %(<a href="mailto:me@example.org">me@example.org</a></p>\n), output
+  end
+
+  def test_external_link_attributes_override_link_attributes
+    rndr = Redcarpet::Render::HTML.new(:internal_hosts => ["example.com"],
+      :link_attributes => {:rel => "author", :class => "link"},
+      :external_link_attributes => {"rel" => "nofollow noopener"})
+    md = Redcarpet::Markdown.new(rndr)
+    output = md.render("[a](https://example.com/) [b](https://a.org/)")
+
+    assert_equal %(<p><a href="https://example.com/" rel="author" class="link">a</a> ) +
+      %(<a href="https://a.org/" rel="nofollow noopener" class="link">b</a></p>\n), output
+  end
+
+  def test_image_prefixes
+    rndr = Redcarpet::Render::HTML.new(:base_url => "/blog",
+      :image_prefixes => {"/uploads/" => "https://cdn.example.com/", "http://" => "https://"})
+    md = Redcarpet::Markdown.new(rndr)
+    output = md.render("![a](/uploads/a.png) ![b](http://a.org/b.png) ![c](c.png) [d](/uploads/d.png)")
+
+    assert_equal %(<p><img src="https://cdn.example.com/a.png" alt="a"> <img src="https://a.org/b.png" alt="b"> ) +
+      %(<img src="/blog/c.png" alt="c"> <a href="/blog/uploads/d.png">d</a></p>\n), output
+  end
+
+  def test_emoji_image
+    rndr = Redcarpet::Render::HTML.new(:emoji_image => "/emoji/%s.png")
+    md = Redcarpet::Markdown.new(rndr, :emoji => true)
+
+    assert_equal %(<p><img class="emoji" src="/emoji/-1.png" alt="\u{1F44E}" title=":-1:"></p>\n), md.render(":-1:")
+  end
+
   def test_that_link_works_with_quotes
     markdown = %([This'link"is](http://example.net/))
     expected = %(<p><a href="http://example.net/">This&#39;link&quot;is</a></p>\n)
@@ -176,6 +248,24 @@ HTML
     assert_equal expected, output
   end
 
+  def test_footnotes_with_colliding_names
+    # Both names have the same hash
+    markdown = "One[^7eotft] and two[^3rin41]\n\n[^7eotft]: First\n\n[^3rin41]: Second\n"
+    output = render(markdown, with: [:footnotes])
+
+    assert_match %r{<li id="fn1">\n<p>First}, output
+    assert_match %r{<li id="fn2">\n<p>Second}, output
+  end
+
+  def test_links_with_colliding_reference_names
+    # Both names have the same hash
+    markdown = "[One][7eotft] and [two][3rin41]\n\n[7eotft]: /first\n[3rin41]: /second\n"
+    output = render(markdown)
+
+    assert_match %r{<a href="/first">One</a>}, output
+    assert_match %r{<a href="/second">two</a>}, output
+  end
+
   def test_autolink_short_domains
     markdown = "Example of uri ftp://auto/short/domains. Email auto@l.n and link http://a/u/t/o/s/h/o/r/t"
     output   = render(markdown, with: [:autolink])
@@ -185,6 +275,12 @@ HTML
     assert output.include? '<a href="http://a/u/t/o/s/h/o/r/t">http://a/u/t/o/s/h/o/r/t</a>'
   end
 
+  def test_autolink_right_after_markup
+    output = render("_a_b@example.com", with: [:autolink])
+
+    assert_equal "<p><em>a</em><a href=\"mailto:b@example.com\">b@example.com</a></p>\n", output
+  end
+
   def test_that_prettify_works
     markdown = "\tclass Foo\nend"
     output   = render(markdown, with: [:prettify])
@@ -225,6 +321,12 @@ HTML
     assert_not_match %r{img src}, output
   end
 
+  def test_image_without_src
+    output = render("![foo]()")
+
+    assert_match %r{<img src="" alt="foo">}, output
+  end
+
   def test_no_styles_option_inside_a_paragraph
     markdown = "Hello <style> foo { bar: baz; } </style> !"
     output   = render(markdown, with: [:no_styles])
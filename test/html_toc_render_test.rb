@@ -59,6 +59,10 @@ class HTMLTOCRenderTest < Redcarpet::TestCase
     end
   end
 
+  def test_anchor_of_a_header_with_nothing_but_brackets
+    assert_match %(<a href="#">&gt;</a>), render("# >", with: [:escape_html])
+  end
+
   def test_inline_markup_is_not_escaped
     output = render(@markdown)
 
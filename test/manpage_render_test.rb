@@ -0,0 +1,76 @@
+# coding: UTF-8
+require 'test_helper'
+
+class ManPageRender < Redcarpet::TestCase
+  def setup
+    @parser = Redcarpet::Markdown.new(Redcarpet::Render::ManPage, :fenced_code_blocks => true)
+  end
+
+  def test_headers
+    markdown = "# tool(1)\n\n## Name\n\n### Options\n\n#### Dropped"
+    expected = "\n.TH tool(1)\n\n.SH Name\n\n.SS Options\n"
+
+    assert_equal expected, @parser.render(markdown)
+  end
+
+  def test_paragraphs_and_emphasis
+    markdown = "Run it *now*, **twice**."
+    expected = "\n.TP\nRun it\\fInow\\fP,\\fBtwice\\fP.\n"
+
+    assert_equal expected, @parser.render(markdown)
+  end
+
+  def test_lists
+    ordered   = "\n\n.nr step 0 1\n.IP \\n+[step]\none\n.IP \\n+[step]\ntwo\n\n"
+    unordered = "\n.\n.IP \\[bu] 2 \none\n.IP \\[bu] 2 \ntwo\n\n"
+
+    assert_equal ordered, @parser.render("1. one\n2. two\n")
+    assert_equal unordered, @parser.render("* one\n* two\n")
+  end
+
+  def test_code
+    markdown = "```\n.start\n'quoted\npath\\to --flag\n```"
+    expected = "\n.nf\n\\&.start\n\\&'quoted\npath\\eto \\-\\-flag\n.fi\n"
+
+    assert_equal expected, @parser.render(markdown)
+  end
+
+  def test_escaping_text
+    markdown = ".dot at the start, a-b and c\\\\d"
+    expected = "\n.TP\n\\&.dot at the start, a\\-b and c\\ed\n"
+
+    assert_equal expected, @parser.render(markdown)
+  end
+
+  def test_overloading_callbacks
+    render = Class.new(Redcarpet::Render::ManPage) do
+      def emphasis(text)
+        "\\fU#{text}\\fP"
+      end
+    end
+
+    output = Redcarpet::Markdown.new(render).render("an *example*")
+
+    assert_equal "\n.TP\nan\\fUexample\\fP\n", output
+  end
+
+  def test_calling_super_from_callbacks
+    render = Class.new(Redcarpet::Render::ManPage) do
+      def header(title, level)
+        super.sub(".TH", ".SH")
+      end
+    end
+
+    output = Redcarpet::Markdown.new(render).render("# title\n\nan *example*")
+
+    assert_equal "\n.SH title\n\n.TP\nan\\fIexample\\fP\n", output
+  end
+
+  def test_callbacks_as_methods
+    renderer = Redcarpet::Render::ManPage.new
+
+    assert_equal "\\fBstrong\\fP", renderer.double_emphasis("strong")
+    assert_equal "\n.SS title\n", renderer.header("title", 3)
+    assert_equal ".IP \\n+[step]\none\n", renderer.list_item("one", :ordered)
+  end
+end
@@ -58,6 +58,13 @@ class MarkdownTest < Redcarpet::TestCase
       markdown
   end
 
+  def test_deeply_nested_list_items_are_kept
+    text = (0..6).map { |level| "    " * level + "* level #{level}\n" }.join
+    output = @markdown.render(text)
+
+    (0..6).each { |level| assert_match "<li>level #{level}", output }
+  end
+
   def test_para_before_block_html_should_not_wrap_in_p_tag
     markdown = render_with({:lax_spacing => true},
       "Things to watch out for\n" +
@@ -214,6 +221,44 @@ EOS
     assert output.include? '<q>quote</q>'
   end
 
+  def test_emoji_flag_works
+    text = "this is :tada: :+1: but not a:tada:, :nothing: or `:tada:`"
+
+    refute render_with({}, text).include? "\u{1F389}"
+
+    output = render_with({:emoji => true}, text)
+    assert_equal "<p>this is \u{1F389} \u{1F44D} but not a:tada:, :nothing: or <code>:tada:</code></p>\n", output
+  end
+
+  def test_emoji_flag_with_autolink
+    output = render_with({:emoji => true, :autolink => true}, ":heart: http://example.com/:heart:")
+    assert_equal "<p>\u{2764}\u{FE0F} <a href=\"http://example.com/:heart:\">http://example.com/:heart:</a></p>\n", output
+  end
+
+  def test_mentions_and_issues
+    text = "Thanks @jane-doe, fixes #12 (not a#1, me@x or `@code #1`)"
+    refs = {:mentions => "/users/%s", :issues => "/issues/%s"}
+
+    refute render_with({}, text).include? "<a"
+
+    output = render_with(refs, text)
+    assert_equal "<p>Thanks <a href=\"/users/jane-doe\">@jane-doe</a>, fixes <a href=\"/issues/12\">#12</a> " \
+                 "(not a#1, me@x or <code>@code #1</code>)</p>\n", output
+  end
+
+  def test_mentions_are_not_linked_inside_links
+    output = render_with({:mentions => "/users/%s", :autolink => true}, "[@jane](/j) @john me@example.com")
+    assert_equal "<p><a href=\"/j\">@jane</a> <a href=\"/users/john\">@john</a> " \
+                 "<a href=\"mailto:me@example.com\">me@example.com</a></p>\n", output
+  end
+
+  def test_escaped_mentions_and_issues_are_text
+    refs = {:mentions => "/users/%s", :issues => "/issues/%s"}
+
+    assert_equal "<p>@jane #12</p>\n", render_with(refs, "\\@jane \\#12")
+    assert_equal "<p>\\@jane</p>\n", render_with({}, "\\@jane")
+  end
+
   def test_that_fenced_flag_works
     text = <<fenced
 This is a simple test
@@ -300,6 +345,7 @@ text
     assert render_with({:no_intra_emphasis => true}, "this fails: hello_world_") !~ /<em>/
     assert render_with({:no_intra_emphasis => true}, "this also fails: hello_world_#bye") !~ /<em>/
     assert render_with({:no_intra_emphasis => true}, "this works: hello_my_world") !~ /<em>/
+    assert render_with({:no_intra_emphasis => true}, "this also fails: *hello world*foo") !~ /<em>/
     assert render_with({:no_intra_emphasis => true}, "句中**粗體**測試") =~ /<strong>/
 
     markdown = "This is (**bold**) and this_is_not_italic!"
@@ -316,6 +362,10 @@ text
     html_equal "<p><strong>foo*</strong> <em>dd_dd</em></p>\n", markdown
   end
 
+  def test_escaped_emphasis_char_in_a_broken_link_closes_emphasis
+    assert_equal "<p><em>-[ \\</em>a</p>\n", @markdown.render("*-[ \\*a")
+  end
+
   def test_char_escaping_when_highlighting
     markdown = "==attribute\\==="
     output = render_with({highlight: true}, markdown)
@@ -334,4 +384,119 @@ text
     markdown = @markdown.render("[Link][id]\n[id]:\t\t\thttp://google.es")
     html_equal "<p><a href=\"http://google.es\">Link</a></p>\n", markdown
   end
+
+  def test_render_within_limits
+    html_equal "<p><em>Hello</em></p>\n",
+      @markdown.render("*Hello*", :max_output => 100, :max_triggers => 1, :timeout => 10)
+  end
+
+  def test_render_stops_past_max_output
+    error = assert_raise(Redcarpet::RenderLimitExceeded) do
+      @markdown.render("Some *text*.\n\n" * 1000, :max_output => 100)
+    end
+
+    assert_equal :max_output, error.reason
+    assert error.partial.start_with?("<p>Some <em>text</em>.</p>")
+    assert error.partial.size < 200
+  end
+
+  def test_render_stops_past_max_triggers
+    error = assert_raise(Redcarpet::RenderLimitExceeded) do
+      @markdown.render("*a* *b* *c* *d*", :max_triggers => 2)
+    end
+
+    assert_equal :max_triggers, error.reason
+    assert_equal "<p><em>a</em> <em>b</em> </p>\n", error.partial
+  end
+
+  def test_render_stops_at_timeout
+    error = assert_raise(Redcarpet::RenderLimitExceeded) do
+      @markdown.render("Some *text*.\n\n" * 1000, :timeout => 0)
+    end
+
+    assert_equal :timeout, error.reason
+  end
+
+  def test_excerpt_stops_after_length_at_a_word_boundary
+    text = "Some *emphasised* text with `code` in it.\n\nAnother paragraph."
+
+    assert_equal "<p>Some <em>emphasised</em> text</p>\n", @markdown.excerpt(text, :length => 22)
+    assert_equal "<p>Some</p>\n", @markdown.excerpt(text, :length => 8)
+    assert_equal @markdown.render(text), @markdown.excerpt(text, :length => 1000)
+  end
+
+  def test_excerpt_stops_after_blocks
+    text = "# Title\n\n* one\n* two\n\nLast paragraph."
+
+    assert_equal "<h1>Title</h1>\n\n<ul>\n<li>one</li>\n<li>two</li>\n</ul>\n",
+      @markdown.excerpt(text, :blocks => 2)
+  end
+
+  def test_stats
+    markdown = Redcarpet::Markdown.new(Redcarpet::Render::HTML, :tables => true, :autolink => true)
+    text = "# A title\n\nSome *emphasised* te**xt** with [a link](/a) and ![an image](/b.png).\n\n" \
+           "    some\n    code\n\n* one\n* two, at http://example.org\n\na | b\n---|---\nc | d\n"
+
+    stats = markdown.stats(text)
+
+    assert_equal 17, stats[:words]
+    assert_equal 1, stats[:paragraphs]
+    assert_equal [1, 1, 2], stats.values_at(:headers, :lists, :list_items)
+    assert_equal [1, 2, 1], stats.values_at(:code_blocks, :code_lines, :tables)
+    assert_equal [2, 1], stats.values_at(:links, :images)
+  end
+
+  def test_extract_links
+    markdown = Redcarpet::Markdown.new(Redcarpet::Render::HTML, :autolink => true)
+    text = "See [one](/one \"One\") or [two] at http://example.org.\n\n" \
+           "[![logo](/logo.png)](/home)\n\n[two]: /two\n"
+
+    links = markdown.extract_links(text)
+
+    assert_equal [:inline, :reference, :autolink, :inline, :image], links.map { |l| l[:kind] }
+    assert_equal ["/one", "/two", "http://example.org", "/home", "/logo.png"], links.map { |l| l[:url] }
+    assert_equal ["One", nil], links.first(2).map { |l| l[:title] }
+    assert_equal [4, 25, 34, 55, 56], links.map { |l| l[:offset] }
+  end
+
+  def test_extract_links_with_mentions_and_issues
+    markdown = Redcarpet::Markdown.new(Redcarpet::Render::HTML, :mentions => "/users/%s", :issues => "/issues/%s")
+    links = markdown.extract_links("@jane fixed #4")
+
+    assert_equal [:mention, :issue], links.map { |l| l[:kind] }
+    assert_equal ["/users/jane", "/issues/4"], links.map { |l| l[:url] }
+    assert_equal [0, 12], links.map { |l| l[:offset] }
+  end
+
+  def test_extract_links_in_footnotes
+    markdown = Redcarpet::Markdown.new(Redcarpet::Render::HTML, :footnotes => true)
+    text = "Text[^1] and [a](/a).\n\n[^1]: See [b](/b).\n"
+
+    assert_equal [13, 33], markdown.extract_links(text).map { |l| l[:offset] }
+  end
+
+  def test_headings
+    text = "# A *nice* title\n\nText\n\nCode `a<b`\n---\n\n> ### Quoted\n"
+
+    headings = @markdown.headings(text)
+
+    assert_equal [1, 2, 3], headings.map { |h| h[:level] }
+    assert_equal ["A nice title", "Code a<b", "Quoted"], headings.map { |h| h[:text] }
+    assert_equal ["a-nice-title", "code-altb", "quoted"], headings.map { |h| h[:anchor] }
+    assert_equal [0, 24, 42], headings.map { |h| h[:offset] }
+  end
+
+  def test_headings_anchors_match_the_toc
+    toc = Redcarpet::Markdown.new(Redcarpet::Render::HTML_TOC)
+    text = "# Hello World\n## Foo + Bar\n## *Em* here\n### A.B!\n"
+
+    assert_equal toc.render(text).scan(/href="#([^"]*)"/).flatten,
+      @markdown.headings(text).map { |h| h[:anchor] }
+  end
+
+  def test_excerpt_leaves_out_what_it_cuts_to_nothing
+    text = "* first item\n* second item\n\n" * 100
+
+    assert_equal "<ul>\n<li>first item</li>\n</ul>\n", @markdown.excerpt(text, :length => 14)
+  end
 end
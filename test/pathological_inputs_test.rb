@@ -28,6 +28,22 @@ class PathologicalInputsTest # < Redcarpet::TestCase
     @markdown.render(" [^a]: #{ "A" * 10000 }\n#{ "[^a][]" * 1000000 }\n")
   end
 
+  def test_unmatched_emphasis
+    @markdown.render("*a **b ~~c _d " * 50000)
+  end
+
+  def test_unmatched_brackets
+    @markdown.render("[a [b](c ![d](e \"f " * 50000)
+  end
+
+  def test_nested_brackets
+    @markdown.render("[" * 50000 + "a" + "]" * 50000)
+  end
+
+  def test_unclosed_html_blocks
+    @markdown.render("<div>\ntext </div> x\n\n" * 50000)
+  end
+
   def test_unbound_recursion
     @markdown.render(("[" * 10000) + "foo" + ("](bar)" * 10000))
   end
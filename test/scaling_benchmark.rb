@@ -0,0 +1,121 @@
+# coding: UTF-8
+# Renders every family of constructs at 1x, 2x, 4x ... 256x its base
+# size and fits how the render time grows with the input; the nested
+# families also nest deeper as they grow. Anything growing clearly
+# faster than linear is flagged and makes the run fail.
+#
+#   SCALE_MAX=64      largest multiple to render (a power of two)
+#   SCALE_LIMIT=1.25  highest growth exponent still taken as linear
+#   SCALE_ONLY=lists  only run the families whose name matches
+require 'redcarpet'
+
+max_scale = Integer(ENV['SCALE_MAX'] || 256)
+limit     = Float(ENV['SCALE_LIMIT'] || 1.25)
+only      = ENV['SCALE_ONLY'] && Regexp.new(ENV['SCALE_ONLY'])
+
+# Nesting depth at scale n: 1 at 1x, up to the deepest one the parser
+# still renders in full (its nesting limit is 16) at the largest scale.
+depth = lambda do |n, deepest|
+  1 + ((deepest - 1) * Math.log2(n) / Math.log2([max_scale, 2].max)).round
+end
+
+FAMILIES = {
+  'nested quotes' => [{}, lambda do |n|
+    ((1..depth.call(n, 14)).map { |d| "#{'> ' * d}quoted *text*\n" }.join + "\n") * n
+  end],
+
+  'nested lists' => [{}, lambda do |n|
+    ((0...depth.call(n, 7)).map { |d| "#{'    ' * d}* item *text*\n" }.join + "\n") * n
+  end],
+
+  'emphasis runs' => [{ :strikethrough => true, :highlight => true }, lambda do |n|
+    "*a **b ~~c _d ==e " * (16 * n)
+  end],
+
+  'bracket runs' => [{}, lambda do |n|
+    "[a [b](c ![d](e \"f " * (16 * n) + "\n\n" +
+      "[" * (16 * n) + "a" + "]" * (16 * n)
+  end],
+
+  'unclosed html blocks' => [{}, lambda do |n|
+    "<div>\ntext </div> x\n\n" * (16 * n)
+  end],
+
+  'big tables' => [{ :tables => true }, lambda do |n|
+    "a | b | c\n---|:---:|---:\n" + "x | *y* | `z`\n" * (32 * n)
+  end],
+
+  'many refs' => [{}, lambda do |n|
+    (0...16 * n).map { |i| "[link][r#{i}] " }.join + "\n\n" +
+      (0...16 * n).map { |i| "[r#{i}]: /url/#{i} \"title\"\n" }.join
+  end],
+
+  'many footnotes' => [{ :footnotes => true }, lambda do |n|
+    (0...16 * n).map { |i| "text[^f#{i}]\n\n[^f#{i}]: note #{i}\n\n" }.join
+  end],
+
+  'autolink dense text' => [{ :autolink => true }, lambda do |n|
+    "see http://example.com/a, foo@example.com or www.example.com; " * (16 * n) +
+      "\n\n" + "a@" * (16 * n)
+  end],
+
+  'reference dense text' => [{ :autolink => true, :mentions => '/u/%s', :issues => '/i/%s' }, lambda do |n|
+    "thanks @someone for #123, cc @other-one and foo@example.com; " * (16 * n)
+  end],
+}
+
+# Time of one render, taking the best of a few rounds of enough renders
+# to rise above the timer's resolution.
+def time_render(markdown, doc)
+  (1..5).map do
+    count = 0
+    start = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+    begin
+      markdown.render(doc)
+      count += 1
+      elapsed = Process.clock_gettime(Process::CLOCK_MONOTONIC) - start
+    end while elapsed < 0.05
+    elapsed / count
+  end.min
+end
+
+# Least squares slope of log(time) over log(size).
+def growth(points)
+  xs = points.map { |size, _| Math.log(size) }
+  ys = points.map { |_, time| Math.log(time) }
+  mx = xs.inject(:+) / xs.size
+  my = ys.inject(:+) / ys.size
+
+  xs.zip(ys).map { |x, y| (x - mx) * (y - my) }.inject(:+) /
+    xs.map { |x| (x - mx) ** 2 }.inject(:+)
+end
+
+scales = [1]
+scales << scales.last * 2 while scales.last < max_scale
+flagged = []
+
+FAMILIES.each do |name, (extensions, generate)|
+  next if only && name !~ only
+
+  markdown = Redcarpet::Markdown.new(Redcarpet::Render::HTML, extensions)
+  docs = scales.map { |scale| generate.call(scale) }
+  points = exponent = nil
+
+  # a family only gets flagged when a second run agrees with the first,
+  # as a busy machine can throw off a single one
+  2.times do
+    points = docs.map { |doc| [doc.bytesize, time_render(markdown, doc)] }
+
+    # fit the largest sizes only: below them the time is mostly the fixed
+    # cost of a call, and steps as the working set outgrows each cache
+    exponent = growth(points.last(4))
+    break if exponent <= limit
+  end
+
+  flagged << name if exponent > limit
+
+  printf("%-22s %9d bytes %9.3fms  n^%.2f%s\n", name, points.last[0],
+    points.last[1] * 1000, exponent, exponent > limit ? '  <- worse than linear' : '')
+end
+
+abort "\nGrowing faster than linear: #{flagged.join(', ')}" unless flagged.empty?
@@ -37,4 +37,65 @@ class StripDownRender < Redcarpet::TestCase
 
     assert_equal expected, output
   end
+
+  def test_tables
+    parser = Redcarpet::Markdown.new(Redcarpet::Render::StripDown, :tables => true)
+    markdown = "Name | Value\n-----|------\n*a*  | 1\n     | 2\n"
+    expected = "Name\tValue\na\t1\n\t2\n"
+
+    assert_equal expected, parser.render(markdown)
+  end
+
+  def test_span_extensions_and_footnotes
+    parser = Redcarpet::Markdown.new(Redcarpet::Render::StripDown,
+      :quote => true, :highlight => true, :underline => true, :footnotes => true)
+    markdown = "A \"quote\", ==marked== and _underlined_ text[^1]\n\n[^1]: The note"
+    expected = "A \"quote\", marked and underlined text[1]\nThe note\n"
+
+    assert_equal expected, parser.render(markdown)
+  end
+
+  class UpcasedStripDown < Redcarpet::Render::StripDown
+    def emphasis(text)
+      text.upcase
+    end
+  end
+
+  def test_overloading_callbacks
+    parser = Redcarpet::Markdown.new(UpcasedStripDown)
+
+    assert_equal "Some LOUD text\n", parser.render("Some *loud* text")
+  end
+
+  class BracketedStripDown < Redcarpet::Render::StripDown
+    def link(link, title, content)
+      "[#{super}]"
+    end
+  end
+
+  def test_calling_super_from_callbacks
+    parser = Redcarpet::Markdown.new(BracketedStripDown)
+
+    assert_equal "A [link (http://example.org)] and *more*\n",
+      parser.render("A [link](http://example.org) and \\*more\\*")
+  end
+
+  def test_callbacks_as_methods
+    renderer = Redcarpet::Render::StripDown.new
+
+    assert_equal "text (http://example.org)", renderer.link("http://example.org", nil, "text")
+    assert_equal "A title\n", renderer.header("A title", 1)
+    assert_equal "alt http://example.org/a.png", renderer.image("http://example.org/a.png", nil, "alt")
+    assert_equal "[2]", renderer.footnote_ref(2)
+  end
+
+  def test_excerpts
+    markdown = "# A title\n\nA [first](http://example.org) paragraph, " \
+               "with __strong__ words.\n\n    some code\n\n" * 50
+
+    assert_equal "A title\nA first (http://example.org) paragraph, with\n",
+      @parser.excerpt(markdown, :length => 35)
+    assert_equal "A title\nA first (http://example.org) paragraph, with strong words.\n" \
+                 "some code\nA title\n", @parser.excerpt(markdown, :blocks => 4)
+  end
 end